@@ -4,6 +4,8 @@
 
 #pragma once
 #include <memory>
+#include <cstdlib>
+#include <cstring>
 #include <cassert>
 
 // reader can unload bytes into here.
@@ -11,8 +13,9 @@
 class RawData_Buff {
 
     inline void cleanup(){
-        if(_data != nullptr){  _aligned_free(_data);  }
+        if(_data != nullptr && _ownsData){  free_aligned(_data);  }
         _data = nullptr;
+        _ownsData = true;
         _allocatedSize = _size = _currIx = 0;
     }
 
@@ -20,9 +23,30 @@ class RawData_Buff {
     RawData_Buff& operator=(const RawData_Buff& other) = delete;
 
 public:
-    RawData_Buff(size_t sizeBytes){
-        _data = (unsigned char*)_aligned_malloc(sizeBytes, 16);
+    // 'alignment' must be a power of two.
+    static void* alloc_aligned(size_t sizeBytes, size_t alignment){
+    #ifdef _WIN32
+        return _aligned_malloc(sizeBytes, alignment);
+    #else
+        //std::aligned_alloc wants the size to be a multiple of alignment:
+        const size_t rounded = ((sizeBytes + alignment - 1) / alignment) * alignment;
+        return std::aligned_alloc(alignment, rounded == 0 ? alignment : rounded);
+    #endif
+    }
+
+    static void free_aligned(void* p){
+    #ifdef _WIN32
+        _aligned_free(p);
+    #else
+        std::free(p);
+    #endif
+    }
+
+public:
+    RawData_Buff(size_t sizeBytes,  size_t alignment = 16){
+        _data = (unsigned char*)alloc_aligned(sizeBytes, alignment);
         _allocatedSize = sizeBytes;
+        _alignment = alignment;
         _size = 0;//see 'set_apparent_size()'
         _currIx = 0;
     }
@@ -37,6 +61,7 @@ public:
     void reset_ix() { _currIx = 0; }
     size_t size()const{ return _size; }
     size_t totalAlocatedSize()const{ return _allocatedSize; }
+    size_t alignment()const{ return _alignment; }
     size_t remaining()const{ return _size - _currIx; }
     void skipBytes(size_t numBytes){ _currIx+=numBytes; }
     bool endReached(){ return _currIx >= _size;  }
@@ -45,6 +70,7 @@ public:
      void fill(const unsigned char* buff,  size_t numBytes ){
         //you can't write more bytes than what was allocated in our constructor:
          assert(numBytes <= _allocatedSize);
+         assert(_ownsData);
         _size = numBytes;
         std::memcpy(_data, buff, numBytes);
     }
@@ -56,11 +82,32 @@ public:
     }
 
 
+    // Discards the contents, and allocates a different amount of memory.
+    void reallocate(size_t sizeBytes,  size_t alignment){
+        cleanup();
+        _data = (unsigned char*)alloc_aligned(sizeBytes, alignment);
+        _allocatedSize = sizeBytes;
+        _alignment = alignment;
+    }
+
+
+    // Frees our memory, and from now on reads someone else's bytes instead (no copy).
+    // They must stay alive while we are used. Useful if bytes are already in RAM.
+    void set_view(const unsigned char* bytes,  size_t numBytes){
+        cleanup();
+        _data = const_cast<unsigned char*>(bytes);//we never write through it.
+        _ownsData = false;
+        _allocatedSize = _size = numBytes;
+    }
+
+
 private:
     unsigned char* _data = nullptr;
+    bool _ownsData = true;//false if set_view() was used.
 
     size_t _size = 0;//less than or equal to '_allocatedSize' (in bytes)
     size_t _allocatedSize = 0;//(in bytes)
+    size_t _alignment = 16;
 
     size_t _currIx = 0;//how far we are into _data.
 };
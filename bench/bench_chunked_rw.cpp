@@ -0,0 +1,500 @@
+// MIT LICENSE
+// Requires C++17
+
+// Throughput + per-call latency benchmark for file_read_chunks and file_writer_chunks.
+// Compares them against fread/fwrite, raw read/write and mmap (POSIX only).
+//
+// Build (single translation unit, same flags as the project that includes the headers):
+//     g++ -std=c++17 -O2 -pthread -I.. bench_chunked_rw.cpp -o bench_chunked_rw
+//
+// Usage:
+//     bench_chunked_rw [dir] [--size MB] [--chunks 4K,64K,1M,...] [--cold] [--no-latency]
+//                      [--sim MBps:latency_us:jitter_us]
+//
+//  dir           where temporary files are created (default: current directory).
+//                Point it at the device you want to measure.
+//  --size        bytes written/read per run: a plain number is in MB, or with a suffix: 512K, 64M, 1G (default 256)
+//  --chunks      chunk sizes to try (default 4K,16K,64K,256K,1M,4M,16M,64M)
+//  --cold        on Linux, evict the file from page cache before every read (posix_fadvise)
+//  --no-latency  skip the second (timed per-call) pass
+//  --sim         also run the chunked engines on a 'throttled_backend' that pretends to be
+//                a device with this bandwidth and per-request latency. For example an HDD:
+//                --sim 150:8000:4000
+//
+// Engines:  "chunked" is the default backend of this platform, "chunk-fs" is the same classes on
+//           std::fstream (only listed where that isn't the default),
+//           "memory" is memory_source_backend / memory_sink_backend (no disk at all),
+//           "simulated" is the throttled_backend from --sim, "sim-memory" is the same device
+//           in front of the memory backends (so only the simulated device is measured, no disk).
+//
+// Every configuration is run twice: an untimed pass for GB/s, and a pass where every call
+// is timed to get latency percentiles. "stall" is the total time spent in calls that took
+// longer than 'k_stallThreshold' - those are the calls that waited for the disk
+// (join of the load thread, or waiting for a flush), instead of just copying bytes.
+
+#include "standalone_shims.h"//LogConsole, nn_dev_assert
+
+#include "../file_read_chunks.h"
+#include "../file_write_chunks.h"
+#include "../throttled_backend.h"
+#include "../memory_backends.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <cctype>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #define BENCH_HAS_POSIX 1
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+namespace {
+
+using clock_t_ = std::chrono::steady_clock;
+constexpr double k_stallThreshold_ns = 20'000;//a call longer than 20us almost certainly waited on I/O
+
+enum class Pattern { Literals, Strings, Blobs };
+constexpr size_t k_stringLen = 32;
+constexpr size_t k_blobLen = 1024*1024;
+
+const char* pattern_name(Pattern p){
+    switch(p){
+        case Pattern::Literals: return "literals";
+        case Pattern::Strings:  return "strings";
+        default:                return "blobs";
+    }
+}
+
+size_t pattern_callBytes(Pattern p){
+    switch(p){
+        case Pattern::Literals: return sizeof(uint64_t);
+        case Pattern::Strings:  return k_stringLen;
+        default:                return k_blobLen;
+    }
+}
+
+
+// log2 histogram of call durations, cheap enough to update on every call.
+struct LatencyHist {
+    static constexpr int k_buckets = 40;
+    uint64_t counts[k_buckets] = {};
+    uint64_t numCalls = 0;
+    double stall_ns = 0;
+    double max_ns = 0;
+
+    void add(double ns){
+        int b = 0;
+        for(uint64_t v = (uint64_t)ns;  v > 1 && b < k_buckets-1;  v >>= 1){ ++b; }
+        ++counts[b];
+        ++numCalls;
+        if(ns > k_stallThreshold_ns){ stall_ns += ns; }
+        if(ns > max_ns){ max_ns = ns; }
+    }
+
+    //upper bound of the bucket that contains the given percentile.
+    //NOTICE: never above the slowest call we saw, the last bucket can be much wider than it.
+    double percentile_ns(double pct)const{
+        if(numCalls == 0){ return 0; }
+        const uint64_t target = (uint64_t)(pct * numCalls);
+        uint64_t seen = 0;
+        for(int b=0; b<k_buckets; ++b){
+            seen += counts[b];
+            if(seen > target){ return std::min(double(2ull << b),  max_ns); }
+        }
+        return max_ns;
+    }
+};
+
+
+struct Result {
+    std::string engine;
+    std::string op;
+    Pattern pattern = Pattern::Blobs;
+    size_t chunkBytes = 0;
+    double seconds = 0;
+    size_t bytes = 0;
+    LatencyHist lat;
+    bool hasLat = false;
+};
+
+
+struct Options {
+    std::string dir = ".";
+    size_t totalBytes = 256ull*1024*1024;
+    std::vector<size_t> chunkSizes = { 4<<10, 16<<10, 64<<10, 256<<10, 1<<20, 4<<20, 16<<20, 64<<20 };
+    bool cold = false;
+    bool latency = true;
+    bool useSim = false;
+    simulated_device sim;
+};
+
+
+size_t parse_size(const std::string& s){
+    size_t v = std::stoull(s);
+    const char last = s.empty() ? 0 : s.back();
+    if(last=='K' || last=='k'){ v <<= 10; }
+    if(last=='M' || last=='m'){ v <<= 20; }
+    if(last=='G' || last=='g'){ v <<= 30; }
+    return v;
+}
+
+
+Options parse_args(int argc, char** argv){
+    Options o;
+    for(int i=1; i<argc; ++i){
+        std::string a = argv[i];
+        if(a=="--size" && i+1<argc){
+            const std::string v = argv[++i];
+            const bool hasSuffix = !v.empty()  &&  !std::isdigit((unsigned char)v.back());
+            o.totalBytes = hasSuffix ? parse_size(v) : parse_size(v) << 20;
+        }
+        else if(a=="--chunks" && i+1<argc){
+            o.chunkSizes.clear();
+            std::string list = argv[++i];
+            size_t start = 0;
+            while(start < list.size()){
+                size_t comma = list.find(',', start);
+                if(comma == std::string::npos){ comma = list.size(); }
+                o.chunkSizes.push_back( parse_size(list.substr(start, comma-start)) );
+                start = comma+1;
+            }
+        }
+        else if(a=="--cold"){ o.cold = true; }
+        else if(a=="--no-latency"){ o.latency = false; }
+        else if(a=="--sim" && i+1<argc){
+            double mbps = 0;  long long lat = 0, jit = 0;
+            if(std::sscanf(argv[++i], "%lf:%lld:%lld", &mbps, &lat, &jit) < 1){ throw std::runtime_error("bad --sim"); }
+            o.useSim = true;
+            o.sim.bandwidth_bytesPerSec = mbps * 1e6;
+            o.sim.latency = std::chrono::microseconds(lat);
+            o.sim.jitter = std::chrono::microseconds(jit);
+        }
+        else { o.dir = a; }
+    }
+    return o;
+}
+
+
+// Deterministic payload, so the reader can't be "optimised" by reading zero pages.
+std::vector<unsigned char> make_payload(size_t n){
+    std::vector<unsigned char> v(n);
+    uint64_t x = 0x9E3779B97F4A7C15ull;
+    for(size_t i=0; i<n; ++i){
+        x ^= x << 13;  x ^= x >> 7;  x ^= x << 17;
+        v[i] = (unsigned char)x;
+    }
+    return v;
+}
+
+
+void evict_from_cache(const std::string& path){
+#if defined(BENCH_HAS_POSIX) && defined(POSIX_FADV_DONTNEED)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if(fd < 0){ return; }
+    ::fdatasync(fd);
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    ::close(fd);
+#else
+    (void)path;
+#endif
+}
+
+
+// Invokes 'call(offset, numBytes)' until 'total' bytes are consumed,
+// optionally timing every invocation.
+template<typename Fn>
+void run_calls(size_t total, size_t callBytes, LatencyHist* lat, Fn&& call){
+    size_t done = 0;
+    while(done < total){
+        const size_t n = std::min(callBytes, total-done);
+        if(lat){
+            auto t0 = clock_t_::now();
+            call(done, n);
+            lat->add( std::chrono::duration<double, std::nano>(clock_t_::now() - t0).count() );
+        }else{
+            call(done, n);
+        }
+        done += n;
+    }
+}
+
+
+template<typename Fn>
+double timed(Fn&& fn){
+    auto t0 = clock_t_::now();
+    fn();
+    return std::chrono::duration<double>(clock_t_::now() - t0).count();
+}
+
+
+//---------------------------------------------------------------------------
+// chunked engines
+//---------------------------------------------------------------------------
+template<typename Backend>  struct is_throttled : std::false_type {};
+template<typename Inner>    struct is_throttled<throttled_backend<Inner>> : std::true_type {};
+
+
+template<typename Backend>
+void bench_chunked_write(const Options& o, const std::string& path, const std::vector<unsigned char>& payload,
+                         Pattern pat, size_t chunk, LatencyHist* lat, Result& r){
+    basic_file_writer_chunks<Backend> w;
+    if constexpr (is_throttled<Backend>::value){  w.backend().set_device(o.sim);  }
+    const size_t callBytes = pattern_callBytes(pat);
+    r.seconds = timed([&]{
+        w.beginWrite(path, 0, std::ios::trunc, std::max<size_t>(chunk, 1024));
+        run_calls(o.totalBytes, callBytes, lat, [&](size_t off, size_t n){
+            if(pat == Pattern::Literals){
+                uint64_t v;  std::memcpy(&v, payload.data()+off, sizeof(v));
+                w.writeBytes(&v, sizeof(v));
+            }else{
+                w.writeBytes(payload.data()+off, n);
+            }
+        });
+        w.completeWrite();
+    });
+    r.bytes = o.totalBytes;
+}
+
+
+template<typename Backend>
+void bench_chunked_read(const Options& o, const std::string& path, const std::vector<unsigned char>& payload, Pattern pat, size_t chunk,
+                        LatencyHist* lat, Result& r){
+    basic_file_read_chunks<Backend> rd(chunk);
+    if constexpr (is_throttled<Backend>::value){  rd.backend().set_device(o.sim);  }
+    std::vector<char> blob(k_blobLen);
+    std::string str;
+    uint64_t sink = 0;
+    const size_t callBytes = pattern_callBytes(pat);
+
+    if(o.cold){ evict_from_cache(path); }
+    r.seconds = timed([&]{
+        if constexpr (std::is_same_v<Backend, memory_source_backend>){  rd.BeginRead(payload.data(), o.totalBytes);  }
+        else if constexpr (std::is_same_v<Backend, throttled_backend<memory_source_backend>>){
+            rd.backend().inner().set_source(payload.data(), o.totalBytes);
+            rd.BeginRead(path);//'path' is ignored
+        }
+        else{  rd.BeginRead(path);  }
+        run_calls(o.totalBytes, callBytes, lat, [&](size_t, size_t n){
+            switch(pat){
+                case Pattern::Literals: { uint64_t v; rd.read_Literal(v); sink += v; } break;
+                case Pattern::Strings:  { rd.read_String(str, n); sink += (unsigned char)str[0]; } break;
+                default:                { rd.read_rawData(blob.data(), n); sink += (unsigned char)blob[0]; } break;
+            }
+        });
+        rd.EndRead();
+    });
+    r.bytes = o.totalBytes;
+    if(sink == 42){ std::puts(""); }//keep 'sink' alive
+}
+
+
+//---------------------------------------------------------------------------
+// baselines
+//---------------------------------------------------------------------------
+void bench_fwrite(const Options& o, const std::string& path, const std::vector<unsigned char>& payload,
+                  Pattern pat, size_t chunk, LatencyHist* lat, Result& r){
+    r.seconds = timed([&]{
+        FILE* f = std::fopen(path.c_str(), "wb");
+        if(!f){ throw std::runtime_error("fopen failed: " + path); }
+        std::setvbuf(f, nullptr, _IOFBF, chunk);
+        run_calls(o.totalBytes, pattern_callBytes(pat), lat, [&](size_t off, size_t n){
+            std::fwrite(payload.data()+off, 1, n, f);
+        });
+        std::fclose(f);
+    });
+    r.bytes = o.totalBytes;
+}
+
+
+void bench_fread(const Options& o, const std::string& path, Pattern pat, size_t chunk,
+                 LatencyHist* lat, Result& r){
+    std::vector<char> blob(k_blobLen);
+    if(o.cold){ evict_from_cache(path); }
+    r.seconds = timed([&]{
+        FILE* f = std::fopen(path.c_str(), "rb");
+        if(!f){ throw std::runtime_error("fopen failed: " + path); }
+        std::setvbuf(f, nullptr, _IOFBF, chunk);
+        run_calls(o.totalBytes, pattern_callBytes(pat), lat, [&](size_t, size_t n){
+            if(std::fread(blob.data(), 1, n, f) != n){ throw std::runtime_error("short fread"); }
+        });
+        std::fclose(f);
+    });
+    r.bytes = o.totalBytes;
+}
+
+
+#ifdef BENCH_HAS_POSIX
+// Raw syscalls: the caller does its own buffering in 'chunk'-sized pieces, which is
+// what a hand-written loop without a second thread would do.
+void bench_rawWrite(const Options& o, const std::string& path, const std::vector<unsigned char>& payload,
+                    size_t chunk, Result& r){
+    r.seconds = timed([&]{
+        int fd = ::open(path.c_str(), O_WRONLY|O_CREAT|O_TRUNC, 0644);
+        if(fd < 0){ throw std::runtime_error("open failed: " + path); }
+        for(size_t off=0; off<o.totalBytes; off+=chunk){
+            const size_t n = std::min(chunk, o.totalBytes-off);
+            if(::write(fd, payload.data()+off, n) != (ssize_t)n){ ::close(fd); throw std::runtime_error("short write"); }
+        }
+        ::close(fd);
+    });
+    r.bytes = o.totalBytes;
+}
+
+
+void bench_rawRead(const Options& o, const std::string& path, size_t chunk, Result& r){
+    std::vector<char> buf(chunk);
+    if(o.cold){ evict_from_cache(path); }
+    r.seconds = timed([&]{
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){ throw std::runtime_error("open failed: " + path); }
+        size_t total = 0;
+        for(;;){
+            ssize_t got = ::read(fd, buf.data(), chunk);
+            if(got <= 0){ break; }
+            total += (size_t)got;
+        }
+        ::close(fd);
+        if(total != o.totalBytes){ throw std::runtime_error("short read"); }
+    });
+    r.bytes = o.totalBytes;
+}
+
+
+void bench_mmapRead(const Options& o, const std::string& path, Result& r){
+    if(o.cold){ evict_from_cache(path); }
+    uint64_t sink = 0;
+    r.seconds = timed([&]{
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){ throw std::runtime_error("open failed: " + path); }
+        void* p = ::mmap(nullptr, o.totalBytes, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(p == MAP_FAILED){ ::close(fd); throw std::runtime_error("mmap failed"); }
+        const unsigned char* bytes = (const unsigned char*)p;
+        //touch every cache line, otherwise we are only measuring page table setup
+        for(size_t i=0; i<o.totalBytes; i+=64){ sink += bytes[i]; }
+        ::munmap(p, o.totalBytes);
+        ::close(fd);
+    });
+    r.bytes = o.totalBytes;
+    if(sink == 42){ std::puts(""); }
+}
+#endif
+
+
+void print_header(){
+    std::printf("%-10s %-6s %-9s %9s %9s %10s %10s %10s %10s\n",
+                "engine", "op", "pattern", "chunk", "GB/s", "p50(ns)", "p99(ns)", "max(us)", "stall(ms)");
+}
+
+
+void print_result(const Result& r){
+    const double gbs = r.seconds > 0 ? (double)r.bytes / r.seconds / 1e9 : 0;
+    char chunkStr[32];
+    if(r.chunkBytes >= (1u<<20)){ std::snprintf(chunkStr, sizeof(chunkStr), "%zuM", r.chunkBytes>>20); }
+    else{                         std::snprintf(chunkStr, sizeof(chunkStr), "%zuK", r.chunkBytes>>10); }
+
+    if(r.hasLat){
+        std::printf("%-10s %-6s %-9s %9s %9.3f %10.0f %10.0f %10.1f %10.2f\n",
+                    r.engine.c_str(), r.op.c_str(), pattern_name(r.pattern), chunkStr, gbs,
+                    r.lat.percentile_ns(0.5), r.lat.percentile_ns(0.99), r.lat.max_ns/1e3, r.lat.stall_ns/1e6);
+    }else{
+        std::printf("%-10s %-6s %-9s %9s %9.3f %10s %10s %10s %10s\n",
+                    r.engine.c_str(), r.op.c_str(), pattern_name(r.pattern), chunkStr, gbs, "-", "-", "-", "-");
+    }
+    std::fflush(stdout);
+}
+
+
+// Runs 'fn' once for throughput, then (optionally) once more with per-call timing.
+template<typename Fn>
+void measure(const Options& o, Result base, Fn&& fn){
+    Result r = base;
+    fn(nullptr, r);
+    if(o.latency){
+        Result timedRun = base;
+        fn(&timedRun.lat, timedRun);
+        r.lat = timedRun.lat;
+        r.hasLat = true;
+    }
+    print_result(r);
+}
+
+}//namespace
+
+
+
+int main(int argc, char** argv){
+    const Options o = parse_args(argc, argv);
+    const std::string path = (fs::path(o.dir) / "bench_chunked_rw.tmp").string();
+    const std::vector<unsigned char> payload = make_payload(o.totalBytes);
+
+    std::printf("file: %s   size: %zu MB   cold: %s\n\n", path.c_str(), o.totalBytes>>20, o.cold ? "yes" : "no");
+    print_header();
+
+    const Pattern patterns[] = { Pattern::Literals, Pattern::Strings, Pattern::Blobs };
+
+    try {
+        for(size_t chunk : o.chunkSizes){
+            for(Pattern pat : patterns){
+                Result base;  base.pattern = pat;  base.chunkBytes = chunk;
+
+                base.engine = "chunked";  base.op = "write";
+                measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_write<default_io_backend>(o, path, payload, pat, chunk, lat, r); });
+                base.op = "read";
+                measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_read<default_io_backend>(o, path, payload, pat, chunk, lat, r); });
+
+                if constexpr (!std::is_same_v<default_io_backend, fstream_backend>){
+                    base.engine = "chunk-fs";  base.op = "write";
+                    measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_write<fstream_backend>(o, path, payload, pat, chunk, lat, r); });
+                    base.op = "read";
+                    measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_read<fstream_backend>(o, path, payload, pat, chunk, lat, r); });
+                }
+
+                base.engine = "memory";  base.op = "write";
+                measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_write<memory_sink_backend>(o, path, payload, pat, chunk, lat, r); });
+                base.op = "read";
+                measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_read<memory_source_backend>(o, path, payload, pat, chunk, lat, r); });
+
+                if(o.useSim){
+                    base.engine = "simulated";  base.op = "write";
+                    measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_write<throttled_backend<>>(o, path, payload, pat, chunk, lat, r); });
+                    base.op = "read";
+                    measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_read<throttled_backend<>>(o, path, payload, pat, chunk, lat, r); });
+
+                    using sim_sink =   throttled_backend<memory_sink_backend>;
+                    using sim_source = throttled_backend<memory_source_backend>;
+                    base.engine = "sim-memory";  base.op = "write";
+                    measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_write<sim_sink>(o, path, payload, pat, chunk, lat, r); });
+                    base.op = "read";
+                    measure(o, base, [&](LatencyHist* lat, Result& r){ bench_chunked_read<sim_source>(o, path, payload, pat, chunk, lat, r); });
+                }
+
+                base.engine = "stdio";  base.op = "write";
+                measure(o, base, [&](LatencyHist* lat, Result& r){ bench_fwrite(o, path, payload, pat, chunk, lat, r); });
+                base.op = "read";
+                measure(o, base, [&](LatencyHist* lat, Result& r){ bench_fread(o, path, pat, chunk, lat, r); });
+            }
+#ifdef BENCH_HAS_POSIX
+            //pattern doesn't apply to these: they always move whole chunks.
+            Result base;  base.pattern = Pattern::Blobs;  base.chunkBytes = chunk;
+            base.engine = "raw";  base.op = "write";  bench_rawWrite(o, path, payload, chunk, base);  print_result(base);
+            base.op = "read";                         bench_rawRead(o, path, chunk, base);            print_result(base);
+            base.engine = "mmap";                     bench_mmapRead(o, path, base);                  print_result(base);
+#endif
+            std::puts("");
+        }
+    }catch(const std::exception& e){
+        std::fprintf(stderr, "benchmark failed: %s\n", e.what());
+        std::filesystem::remove(path);
+        return 1;
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
@@ -0,0 +1,17 @@
+// MIT LICENSE
+// Requires C++17
+
+#pragma once
+#include <cstdio>
+#include <cassert>
+
+// The headers come from a bigger project, which provides these two.
+// Minimal stand-ins, so the programs in bench/, tools/ and tests/ build on their own.
+// Include it before any of the chunk headers.
+struct LogConsole {
+    static LogConsole& get(){ static LogConsole log;  return log; }
+    void ErrorBad(const char* msg){ std::fprintf(stderr, "%s\n", msg); }
+};
+#ifndef nn_dev_assert
+    #define nn_dev_assert(x) assert(x)
+#endif
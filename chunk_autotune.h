@@ -0,0 +1,137 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <string>
+#include <chrono>
+#include <filesystem>
+#include "file_read_chunks.h"
+#include "file_write_chunks.h"
+#include "chunk_profile.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
+
+// Finds the chunk sizes that work best on the device behind 'targetDir', by writing and
+// reading a test file with file_writer_chunks / file_read_chunks for every candidate size.
+//
+//   chunk_profile p = autotune_chunk_sizes(targetDir);
+//   p.save( chunk_profile::default_path() );   //now every reader/writer uses it by default
+//
+// Or just run tools/chunk_autotune once per host.
+//
+// Only the chunk sizes are tuned: the classes always keep exactly two chunks in flight
+// (one being used, one being loaded/saved), and don't have a direct I/O (O_DIRECT) backend.
+
+struct autotune_options {
+    std::vector<size_t> chunkSizes = { 64<<10, 256<<10, 1<<20, 4<<20, 16<<20, 64<<20 };
+    size_t testFileBytes = 256ull << 20;//should be well above the disk's own cache
+    size_t callBytes = 64 << 10;//how much the user gives/takes per call during the test
+    int repeats = 2;//best of N, to filter out noise from other processes
+    double tolerance = 0.05;//prefer the smaller chunk, if it's within 5% of the fastest one (less RAM)
+};
+
+
+struct autotune_sample {
+    size_t chunkBytes = 0;
+    double write_GBps = 0;
+    double read_GBps = 0;
+};
+
+
+namespace autotune_detail {
+
+    // Without this, reads would come from the page cache, and we would be measuring RAM.
+    inline void evict_from_page_cache(const std::string& path){
+    #if (defined(__unix__) || defined(__APPLE__)) && defined(POSIX_FADV_DONTNEED)
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if(fd < 0){ return; }
+        ::fdatasync(fd);
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        ::close(fd);
+    #else
+        (void)path;
+    #endif
+    }
+
+    template<typename Fn>
+    double seconds_of(Fn&& fn){
+        const auto t0 = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    }
+
+    // picks the smallest chunk whose speed is within 'tolerance' of the fastest.
+    inline size_t pick(const std::vector<autotune_sample>& samples,  double autotune_sample::*speed,  double tolerance,  double* bestSpeed){
+        double best = 0;
+        for(const autotune_sample& s : samples){ best = std::max(best, s.*speed); }
+        size_t chosen = samples.empty() ? 0 : samples.back().chunkBytes;
+        for(const autotune_sample& s : samples){
+            if(s.*speed >= best * (1.0 - tolerance)  &&  s.chunkBytes < chosen){ chosen = s.chunkBytes; }
+        }
+        *bestSpeed = best;
+        return chosen;
+    }
+}
+
+
+// Throws std::runtime_error if the test file can't be written or read.
+// 'samples' (optional) receives the measurement of every candidate.
+template<typename Backend = default_io_backend>
+chunk_profile autotune_chunk_sizes(const std::string& targetDir,
+                                   const autotune_options& opt = autotune_options(),
+                                   std::vector<autotune_sample>* samples = nullptr){
+    const std::string path = (std::filesystem::path(targetDir) / "chunked_rw_autotune.tmp").string();
+    std::vector<unsigned char> payload(opt.callBytes);
+    for(size_t i=0; i<payload.size(); ++i){ payload[i] = (unsigned char)(i * 2654435761u >> 13); }
+
+    std::vector<autotune_sample> results;
+    try{
+        for(size_t chunk : opt.chunkSizes){
+            autotune_sample s;
+            s.chunkBytes = chunk;
+
+            for(int r=0; r<opt.repeats; ++r){
+                const double wSec = autotune_detail::seconds_of([&]{
+                    basic_file_writer_chunks<Backend> w;
+                    w.beginWrite(path, 0, std::ios::trunc, std::max<size_t>(chunk, 1024));
+                    for(size_t done=0; done<opt.testFileBytes; done+=opt.callBytes){ w.writeBytes(payload.data(), opt.callBytes); }
+                    w.completeWrite();
+                });
+                autotune_detail::evict_from_page_cache(path);
+
+                const double rSec = autotune_detail::seconds_of([&]{
+                    basic_file_read_chunks<Backend> rd(chunk);
+                    rd.BeginRead(path);
+                    while(rd.remainingBytes_total() > 0){
+                        const size_t n = std::min(opt.callBytes, rd.remainingBytes_total());
+                        rd.read_rawData((char*)payload.data(), n);
+                    }
+                    rd.EndRead();
+                });
+                s.write_GBps = std::max(s.write_GBps,  (double)opt.testFileBytes / wSec / 1e9);
+                s.read_GBps  = std::max(s.read_GBps,   (double)opt.testFileBytes / rSec / 1e9);
+            }
+            results.push_back(s);
+        }
+    }catch(...){
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        throw;
+    }
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+
+    chunk_profile p;
+    p.calibratedDir = targetDir;
+    if(!results.empty()){
+        p.read_chunkBytes   = autotune_detail::pick(results, &autotune_sample::read_GBps,  opt.tolerance, &p.read_GBps);
+        p.write_bufferBytes = autotune_detail::pick(results, &autotune_sample::write_GBps, opt.tolerance, &p.write_GBps);
+    }
+    if(samples){ *samples = std::move(results); }
+    return p;
+}
@@ -0,0 +1,106 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include "chunk_io_trace.h"
+#include "chunk_probes.h"
+
+// Compile-time instrumentation of basic_file_read_chunks / basic_file_writer_chunks.
+// Give your own type as their 'Hooks' template parameter, to hear about their internal events.
+// For example, to feed a metrics library:
+//
+//   struct my_hooks : no_chunk_hooks {
+//       static constexpr bool enabled = true;
+//       void on_consumer_stall(uint64_t /*chunkIx*/, std::chrono::nanoseconds /*waited*/){ g_stalls.observe(waited); }
+//   };
+//   basic_file_read_chunks<default_io_backend, my_hooks> reader;
+//   reader.hooks()  <-- to reach your object
+//
+// Only "hide" the functions you care about, the rest stay as the empty ones below.
+// If 'enabled' is false (the default), nothing is timed and every call compiles to nothing.
+// Events are per-chunk, never per read_Literal() / writeBytes().
+//
+// NOTICE: on_chunk_loaded and on_flush_complete are invoked from our worker threads,
+// so your functions must be thread-safe.
+struct no_chunk_hooks {
+    static constexpr bool enabled = false;
+
+    // reader: chunk was loaded from the backend (load thread)
+    void on_chunk_loaded(uint64_t /*chunkIx*/,  size_t /*numBytes*/,  std::chrono::nanoseconds /*took*/){}
+    // reader: user thread waited for the chunk it needs. 'waited' is ~0 if it was already loaded.
+    void on_consumer_stall(uint64_t /*chunkIx*/,  std::chrono::nanoseconds /*waited*/){}
+    // writer: buffer was saved to the backend (flush thread, or user thread for the last buffer)
+    void on_flush_complete(uint64_t /*chunkIx*/,  size_t /*numBytes*/,  std::chrono::nanoseconds /*took*/){}
+    // writer: user thread waited for the buffer it wants to refill. ~0 if it was already saved.
+    void on_producer_stall(uint64_t /*chunkIx*/,  std::chrono::nanoseconds /*waited*/){}
+};
+
+
+// One event in progress, see chunk_event_sink::begin()
+struct chunk_event_span {
+    chunk_io_event event;
+    uint64_t t0;//0 if nobody is timing
+    uint64_t chunkIx;
+    uint64_t numBytes;
+};
+
+
+// Used internally by the reader / writer: sends every event to the 'Hooks', to the optional
+// runtime chunk_io_tracer and to the USDT probes, so that each place in the code is only one line.
+//
+//   chunk_event_span ev = _events.begin(chunk_io_event::chunk_load, chunkIx, numBytes);
+//   ...
+//   _events.end(ev);
+//
+template<typename Hooks>
+class chunk_event_sink {
+public:
+    Hooks& hooks(){ return _hooks; }
+
+    void set_tracer(chunk_io_tracer* tracer){ _tracer = tracer; }
+    chunk_io_tracer* tracer()const{ return _tracer; }
+
+    // Timestamp only if someone will look at it.
+    chunk_event_span begin(chunk_io_event e,  uint64_t chunkIx,  uint64_t numBytes = 0)const{
+        switch(e){
+            case chunk_io_event::chunk_load:     CHUNKED_RW_PROBE(read_chunk_submit, chunkIx, numBytes);  break;
+            case chunk_io_event::consumer_wait:  CHUNKED_RW_PROBE(read_wait_begin, chunkIx, numBytes);    break;
+            case chunk_io_event::flush:          CHUNKED_RW_PROBE(write_chunk_submit, chunkIx, numBytes); break;
+            case chunk_io_event::producer_stall: CHUNKED_RW_PROBE(write_wait_begin, chunkIx, numBytes);   break;
+        }
+        uint64_t t0 = 0;
+        if constexpr (Hooks::enabled){ t0 = chunk_io_tracer::now_ns(); }
+        else{  t0 = _tracer ? chunk_io_tracer::now_ns() : 0;  }
+        return chunk_event_span{ e, t0, chunkIx, numBytes };
+    }
+
+    void end(const chunk_event_span& ev){
+        switch(ev.event){
+            case chunk_io_event::chunk_load:     CHUNKED_RW_PROBE(read_chunk_complete, ev.chunkIx, ev.numBytes);  break;
+            case chunk_io_event::consumer_wait:  CHUNKED_RW_PROBE(read_wait_end, ev.chunkIx, ev.numBytes);        break;
+            case chunk_io_event::flush:          CHUNKED_RW_PROBE(write_chunk_complete, ev.chunkIx, ev.numBytes); break;
+            case chunk_io_event::producer_stall: CHUNKED_RW_PROBE(write_wait_end, ev.chunkIx, ev.numBytes);       break;
+        }
+        if(!Hooks::enabled  &&  _tracer == nullptr){ return; }
+
+        const uint64_t t1 = chunk_io_tracer::now_ns();
+        if(_tracer){ _tracer->record(ev.event, ev.t0, t1, ev.chunkIx, ev.numBytes); }
+
+        if constexpr (Hooks::enabled){
+            const std::chrono::nanoseconds took(t1 - ev.t0);
+            switch(ev.event){
+                case chunk_io_event::chunk_load:     _hooks.on_chunk_loaded(ev.chunkIx, ev.numBytes, took); break;
+                case chunk_io_event::consumer_wait:  _hooks.on_consumer_stall(ev.chunkIx, took); break;
+                case chunk_io_event::flush:          _hooks.on_flush_complete(ev.chunkIx, ev.numBytes, took); break;
+                case chunk_io_event::producer_stall: _hooks.on_producer_stall(ev.chunkIx, took); break;
+            }
+        }
+    }
+
+private:
+    Hooks _hooks;
+    chunk_io_tracer* _tracer = nullptr;
+};
@@ -0,0 +1,247 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <algorithm>
+#include "chunk_serialize.h"
+
+// Optional index that file_writer_chunks appends at completeWrite(), and file_read_chunks
+// loads with load_index(). It describes the records of the file, so a reader can jump
+// straight to the part it needs instead of reading everything before it.
+//
+// The file is cut into 'zones' of zoneBytes (the writer's buffer size).
+// Zone maps: for each zone, the offset of the first record that starts in it,
+// and the min / max key of the records that start in it (see markRecord_key()).
+// Bloom filters (optional): for each zone, a bit set that tells if a key is certainly NOT
+// among its records. Good for point lookups when keys aren't sorted (min/max can't rule much out).
+// Record offsets: where every Nth record starts (see markRecord()), to seek by record number.
+// Stored as differences, 7 bits per byte, so a few bytes per entry.
+//
+// Layout, after the data:
+//   [section]...[section]  [footer offset: uint64]  [magic: uint64]
+//   section:  [id: uint32]  [numBytes: uint64]  [bytes]
+// Unknown sections are skipped, so older readers can open files with newer sections.
+
+struct chunk_zone {
+    uint64_t firstRecordOffset = 0;//in the file
+    uint64_t numRecords = 0;//that start in this zone. 0 if the zone is inside a big record.
+    int64_t minKey = 0;
+    int64_t maxKey = 0;
+};
+
+
+struct chunk_index {
+    uint64_t dataBytes = 0;//where the data ends, and the index begins
+    uint64_t zoneBytes = 0;
+    std::vector<chunk_zone> zones;
+    uint32_t bloomHashes = 0;//bits set per key
+    std::vector<std::vector<uint64_t>> blooms;//per zone. Empty if the zone has no keys
+    uint64_t recordStride = 0;//every Nth record is in 'recordOffsets'
+    uint64_t numRecords = 0;
+    std::vector<uint64_t> recordOffsets;
+
+    static constexpr uint64_t k_magic = 0x31305844494B4843ull;//"CHKIDX01"
+    enum section_id : uint32_t {  k_section_zones = 1,  k_section_blooms = 2,  k_section_records = 3  };
+
+
+    bool hasZones()const{ return !zones.empty(); }
+
+    // Where the records of zone 'z' stop (the next record to start is in another zone).
+    uint64_t zone_end(size_t z)const{ return std::min<uint64_t>((z+1) * zoneBytes,  dataBytes); }
+
+    // Can zone 'z' have a record with  lo <= key <= hi ?
+    bool zone_mightMatch(size_t z,  int64_t lo,  int64_t hi)const{
+        const chunk_zone& zone = zones[z];
+        return zone.numRecords > 0  &&  zone.maxKey >= lo  &&  zone.minKey <= hi;
+    }
+
+
+    // Can zone 'z' have a record with this key?  False means certainly not.
+    bool zone_mightContain(size_t z,  int64_t key)const{
+        if(!zone_mightMatch(z, key, key)){ return false; }
+        if(z >= blooms.size()  ||  blooms[z].empty()){ return true; }//has records, but no filter: can't rule it out
+        const std::vector<uint64_t>& bits = blooms[z];
+        const uint64_t numBits = bits.size() * 64;
+        const uint64_t h = hash_key(key);
+        const uint64_t h1 = h,  h2 = (h >> 32) | 1;
+        for(uint32_t i=0; i<bloomHashes; ++i){
+            const uint64_t bit = (h1 + i*h2) % numBits;
+            if((bits[bit / 64] & (1ull << (bit % 64))) == 0){ return false; }
+        }
+        return true;
+    }
+
+
+    static uint64_t hash_key(int64_t key){//splitmix64, spreads nearby keys over all bits
+        uint64_t x = (uint64_t)key + 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    // About 'bitsPerKey * ln2' hashes per key is what gives the fewest false positives.
+    static uint32_t bloom_numHashes(size_t bitsPerKey){
+        const uint32_t k = (uint32_t)(bitsPerKey * 0.69 + 0.5);
+        return std::min<uint32_t>(30,  std::max<uint32_t>(1, k));
+    }
+
+    static std::vector<uint64_t> build_bloom(const uint64_t* keyHashes,  size_t numKeys,
+                                             size_t bitsPerKey,  uint32_t numHashes){
+        const size_t numWords = std::max<size_t>(1,  (numKeys * bitsPerKey + 63) / 64);
+        std::vector<uint64_t> bits(numWords, 0);
+        const uint64_t numBits = numWords * 64;
+        for(size_t k=0; k<numKeys; ++k){
+            const uint64_t h1 = keyHashes[k],  h2 = (keyHashes[k] >> 32) | 1;
+            for(uint32_t i=0; i<numHashes; ++i){
+                const uint64_t bit = (h1 + i*h2) % numBits;
+                bits[bit / 64] |= 1ull << (bit % 64);
+            }
+        }
+        return bits;
+    }
+
+
+    // The writer tells us here where each record starts.
+    void add_record(uint64_t offset){
+        if(numRecords % recordStride == 0){ recordOffsets.push_back(offset); }
+        ++numRecords;
+    }
+
+
+    // The writer gives the keys of records here, as they begin. 'offset' is where the record starts.
+    void add_record_key(uint64_t offset,  int64_t key){
+        const size_t z = (size_t)(offset / zoneBytes);
+        if(zones.size() <= z){ zones.resize(z+1); }
+        chunk_zone& zone = zones[z];
+        if(zone.numRecords == 0){
+            zone.firstRecordOffset = offset;
+            zone.minKey = zone.maxKey = key;
+        }else{
+            zone.minKey = std::min(zone.minKey, key);
+            zone.maxKey = std::max(zone.maxKey, key);
+        }
+        ++zone.numRecords;
+    }
+
+
+    bool empty()const{ return !hasZones() && blooms.empty() && recordOffsets.empty(); }//nothing to store
+
+
+    // Everything that goes after the data: sections and the tail.
+    std::vector<unsigned char> encode_footer()const{
+        byte_sink out;
+        if(hasZones()){
+            byte_sink s;
+            serialize(s, zoneBytes);
+            serialize(s, zones);
+            out.section(k_section_zones, s.bytes);
+        }
+        if(!blooms.empty()){
+            byte_sink s;
+            serialize(s, bloomHashes);
+            serialize(s, blooms);
+            out.section(k_section_blooms, s.bytes);
+        }
+        if(!recordOffsets.empty()){
+            byte_sink s;
+            serialize(s, recordStride);
+            serialize(s, numRecords);
+            serialize(s, (uint64_t)recordOffsets.size());
+            uint64_t prev = 0;
+            for(uint64_t off : recordOffsets){
+                for(uint64_t d = off - prev;  ;  d >>= 7){
+                    const unsigned char b = (unsigned char)(d & 0x7F) | (d > 0x7F ? 0x80 : 0);
+                    s.writeBytes(&b, 1);
+                    if(d <= 0x7F){ break; }
+                }
+                prev = off;
+            }
+            out.section(k_section_records, s.bytes);
+        }
+        serialize(out, dataBytes);
+        serialize(out, k_magic);
+        return std::move(out.bytes);
+    }
+
+    // 'footer' is everything from 'dataBytes' to the end of the file.
+    void decode_footer(const unsigned char* footer,  size_t numBytes){
+        if(numBytes < 2*sizeof(uint64_t)){ throw std::runtime_error("chunk_index: footer is too small"); }
+        byte_source in{ footer,  numBytes - 2*sizeof(uint64_t) };
+        while(in.remainingBytes_total() > 0){
+            uint32_t id = 0;
+            uint64_t sectionBytes = 0;
+            deserialize(in, id);
+            deserialize(in, sectionBytes);
+            if(sectionBytes > in.remainingBytes_total()){ throw std::runtime_error("chunk_index: broken section"); }
+            byte_source s{ in.p,  (size_t)sectionBytes };
+            in.skip((size_t)sectionBytes);
+
+            switch(id){
+                case k_section_zones:
+                    deserialize(s, zoneBytes);
+                    deserialize(s, zones);
+                    if(zoneBytes == 0){ throw std::runtime_error("chunk_index: zone size is 0"); }
+                    break;
+                case k_section_blooms:
+                    deserialize(s, bloomHashes);
+                    deserialize(s, blooms);
+                    break;
+                case k_section_records: {
+                    uint64_t count = 0,  prev = 0;
+                    deserialize(s, recordStride);
+                    deserialize(s, numRecords);
+                    deserialize(s, count);
+                    if(recordStride == 0  ||  count > s.remainingBytes_total()){ throw std::runtime_error("chunk_index: broken record offsets"); }
+                    recordOffsets.resize((size_t)count);
+                    for(uint64_t& off : recordOffsets){
+                        uint64_t d = 0;
+                        for(int shift = 0;  ;  shift += 7){
+                            unsigned char b = 0;
+                            s.read_rawData((char*)&b, 1);
+                            if(shift > 63){ throw std::runtime_error("chunk_index: broken record offsets"); }
+                            d |= (uint64_t)(b & 0x7F) << shift;
+                            if((b & 0x80) == 0){ break; }
+                        }
+                        off = prev + d;
+                        prev = off;
+                    }
+                    break;
+                }
+                default: break;//from a newer version, skip it
+            }
+        }
+    }
+
+
+    // Small adapters, so chunk_serialize.h can write into / read from plain memory.
+    struct byte_sink {
+        std::vector<unsigned char> bytes;
+        void writeBytes(const void* src,  size_t n){
+            const unsigned char* b = (const unsigned char*)src;
+            bytes.insert(bytes.end(), b, b + n);
+        }
+        void section(uint32_t id,  const std::vector<unsigned char>& payload){
+            const uint64_t n = payload.size();
+            writeBytes(&id, sizeof(id));
+            writeBytes(&n, sizeof(n));
+            writeBytes(payload.data(), payload.size());
+        }
+    };
+
+    struct byte_source {
+        const unsigned char* p;
+        size_t n;
+        void read_rawData(char* dst,  size_t numBytes){
+            if(numBytes > n){ throw std::runtime_error("chunk_index: footer ended too early"); }
+            std::memcpy(dst, p, numBytes);
+            skip(numBytes);
+        }
+        void skip(size_t numBytes){ p += numBytes;  n -= numBytes; }
+        size_t remainingBytes_total()const{ return n; }
+    };
+};
@@ -0,0 +1,136 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <string>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <cstdint>
+
+// What the reader / writer was doing during a recorded span of time.
+enum class chunk_io_event : uint8_t {
+    chunk_load,     //reader's load thread, filling one of the buffers from the backend
+    consumer_wait,  //reader's user thread, waiting for the load thread (the chunk wasn't ready yet)
+    flush,          //writer saving one of its buffers to the backend
+    producer_stall, //writer's user thread, waiting until a buffer finishes saving, before it can refill it
+};
+
+
+// Records chunk I/O spans from any number of threads, and saves them as a Chrome trace.
+// Open the result in  chrome://tracing  or  https://ui.perfetto.dev  to see if loads
+// overlap with the processing, or if the user thread keeps waiting for them.
+//
+//   chunk_io_tracer tracer;
+//   reader.set_tracer(&tracer);
+//   ...read...
+//   tracer.export_chrome_json("trace.json");
+//
+// Only chunk-level events are recorded (a few per chunk), never anything per read_Literal().
+// The tracer must outlive the reader/writer it's attached to.
+class chunk_io_tracer {
+public:
+    struct Span {
+        chunk_io_event event;
+        uint32_t tid;//small sequential id of the thread that recorded it
+        uint64_t start_ns;//see now_ns()
+        uint64_t end_ns;
+        uint64_t chunkIx;
+        uint64_t numBytes;
+    };
+
+    chunk_io_tracer()
+        :_origin_ns(now_ns()){
+    }
+
+    // steady_clock, in nanoseconds. The exported trace starts where the tracer was created.
+    static uint64_t now_ns(){
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void record(chunk_io_event e,  uint64_t start_ns,  uint64_t end_ns,  uint64_t chunkIx,  uint64_t numBytes = 0){
+        const Span s{ e, this_thread_id(), start_ns, end_ns, chunkIx, numBytes };
+        std::lock_guard lck(_mu);
+        _spans.push_back(s);
+    }
+
+    std::vector<Span> spans()const{
+        std::lock_guard lck(_mu);
+        return _spans;
+    }
+
+    void clear(){
+        std::lock_guard lck(_mu);
+        _spans.clear();
+    }
+
+    // Chrome "Trace Event Format", which Perfetto UI opens as well.
+    // Returns false if the file couldn't be created.
+    bool export_chrome_json(const std::string& path)const{
+        std::ofstream f(path, std::ios::trunc);
+        if(!f){ return false; }
+
+        std::lock_guard lck(_mu);
+        f << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n";
+
+        //name every thread after what it did first, so tracks are easy to tell apart:
+        std::vector<bool> named;
+        bool first = true;
+        for(const Span& s : _spans){
+            if(s.tid >= named.size()){ named.resize(s.tid+1, false); }
+            if(named[s.tid]){ continue; }
+            named[s.tid] = true;
+            f << (first ? "" : ",\n")
+              << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << s.tid
+              << ",\"args\":{\"name\":\"" << thread_role(s.event) << " " << s.tid << "\"}}";
+            first = false;
+        }
+
+        for(const Span& s : _spans){
+            f << (first ? "" : ",\n")
+              << "{\"name\":\"" << event_name(s.event) << "\",\"cat\":\"chunked_rw\",\"ph\":\"X\",\"pid\":1"
+              << ",\"tid\":" << s.tid
+              << ",\"ts\":" << (double)(s.start_ns - _origin_ns) / 1000.0
+              << ",\"dur\":" << (double)(s.end_ns - s.start_ns) / 1000.0
+              << ",\"args\":{\"chunk\":" << s.chunkIx << ",\"bytes\":" << s.numBytes << "}}";
+            first = false;
+        }
+        f << "\n]}\n";
+        return (bool)f;
+    }
+
+    static const char* event_name(chunk_io_event e){
+        switch(e){
+            case chunk_io_event::chunk_load:     return "chunk_load";
+            case chunk_io_event::consumer_wait:  return "consumer_wait";
+            case chunk_io_event::flush:          return "flush";
+            case chunk_io_event::producer_stall: return "producer_stall";
+        }
+        return "unknown";
+    }
+
+private:
+    static const char* thread_role(chunk_io_event e){
+        switch(e){
+            case chunk_io_event::chunk_load:     return "load";
+            case chunk_io_event::consumer_wait:  return "consumer";
+            case chunk_io_event::flush:          return "flush";
+            case chunk_io_event::producer_stall: return "producer";
+        }
+        return "thread";
+    }
+
+    static uint32_t this_thread_id(){
+        static std::atomic<uint32_t> counter = 0;
+        thread_local uint32_t id = ++counter;
+        return id;
+    }
+
+private:
+    const uint64_t _origin_ns;
+    std::vector<Span> _spans;
+    mutable std::mutex _mu;
+};
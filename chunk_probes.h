@@ -0,0 +1,30 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+
+// Linux USDT (user-level statically defined tracing) probes, provider "chunked_rw".
+// Each probe is a single nop until a tracer attaches, so they are always compiled in
+// when <sys/sdt.h> is available (package 'systemtap-sdt-dev' / 'systemtap-sdt-devel').
+// Define CHUNKED_RW_NO_USDT to remove them completely.
+//
+// Probes  (arg0 = chunk index,  arg1 = bytes):
+//   read_chunk_submit   read_chunk_complete      load thread, around reading one chunk from the backend
+//   read_wait_begin     read_wait_end            user thread, waiting for a chunk that's still loading
+//   write_chunk_submit  write_chunk_complete     saving one buffer to the backend
+//   write_wait_begin    write_wait_end           user thread, waiting for a buffer that's still being saved
+//
+// For example, distribution of chunk load times of a running service:
+//
+//   bpftrace -e '
+//     usdt:/path/to/binary:chunked_rw:read_chunk_submit   { @start[tid] = nsecs; }
+//     usdt:/path/to/binary:chunked_rw:read_chunk_complete /@start[tid]/ {
+//         @load_us = hist((nsecs - @start[tid]) / 1000);  delete(@start[tid]); }'
+
+#if !defined(CHUNKED_RW_NO_USDT) && defined(__linux__) && __has_include(<sys/sdt.h>)
+    #include <sys/sdt.h>
+    #define CHUNKED_RW_PROBE(name, chunkIx, numBytes)  DTRACE_PROBE2(chunked_rw, name, chunkIx, numBytes)
+#else
+    #define CHUNKED_RW_PROBE(name, chunkIx, numBytes)  do{ (void)(chunkIx); (void)(numBytes); }while(0)
+#endif
@@ -0,0 +1,99 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <string>
+#include <fstream>
+#include <cstdlib>
+
+// Chunk sizes that suit this machine. Written by the auto-tuner (see chunk_autotune.h),
+// and used as the default sizes of file_read_chunks / file_writer_chunks.
+//
+// Stored as a small text file of "key=value" lines. Looked up in:
+//    $CHUNKED_RW_PROFILE
+//    $XDG_CONFIG_HOME/chunked_rw.profile   or  ~/.config/chunked_rw.profile
+//    %APPDATA%\chunked_rw.profile           (Windows)
+// If there is no such file, sizes are 0:  the classes then pick them per device
+// when the file is opened (see device_info.h).
+struct chunk_profile {
+    size_t read_chunkBytes  = 0;
+    size_t write_bufferBytes = 0;
+
+    //what the auto-tuner measured with the above. Just for information.
+    double read_GBps = 0;
+    double write_GBps = 0;
+    std::string calibratedDir;
+
+
+    static std::string default_path(){
+        if(const char* p = std::getenv("CHUNKED_RW_PROFILE")){ return p; }
+    #ifdef _WIN32
+        if(const char* appData = std::getenv("APPDATA")){ return std::string(appData) + "\\chunked_rw.profile"; }
+    #else
+        if(const char* xdg = std::getenv("XDG_CONFIG_HOME")){ return std::string(xdg) + "/chunked_rw.profile"; }
+        if(const char* home = std::getenv("HOME")){ return std::string(home) + "/.config/chunked_rw.profile"; }
+    #endif
+        return "";
+    }
+
+
+    // Loaded once, on first use. That's what the constructors use by default.
+    static const chunk_profile& get_default(){
+        static const chunk_profile p = []{
+            chunk_profile loaded;
+            loaded.load(default_path());
+            return loaded;
+        }();
+        return p;
+    }
+
+
+    // Keeps the current values for anything missing or malformed in the file.
+    // Returns false if the file couldn't be opened.
+    bool load(const std::string& path){
+        if(path.empty()){ return false; }
+        std::ifstream f(path);
+        if(!f){ return false; }
+
+        std::string line;
+        while(std::getline(f, line)){
+            const size_t eq = line.find('=');
+            if(line.empty() || line[0]=='#' || eq == std::string::npos){ continue; }
+            const std::string key = line.substr(0, eq);
+            const std::string val = line.substr(eq+1);
+            try{
+                if(key == "read_chunk_bytes"){  read_chunkBytes = sanitize( std::stoull(val) ); }
+                else if(key == "write_buffer_bytes"){ write_bufferBytes = sanitize( std::stoull(val) ); }
+                else if(key == "read_gbps"){  read_GBps = std::stod(val); }
+                else if(key == "write_gbps"){ write_GBps = std::stod(val); }
+                else if(key == "calibrated_dir"){ calibratedDir = val; }
+            }catch(const std::exception&){
+                //ignore this line, keep the value we had.
+            }
+        }
+        return true;
+    }
+
+
+    bool save(const std::string& path)const{
+        if(path.empty()){ return false; }
+        std::ofstream f(path, std::ios::trunc);
+        if(!f){ return false; }
+        f << "# chunked_rw profile, written by chunk_autotune\n"
+          << "read_chunk_bytes="   << read_chunkBytes   << "\n"
+          << "write_buffer_bytes=" << write_bufferBytes << "\n"
+          << "read_gbps="  << read_GBps  << "\n"
+          << "write_gbps=" << write_GBps << "\n"
+          << "calibrated_dir=" << calibratedDir << "\n";
+        return (bool)f;
+    }
+
+private:
+    //a broken profile must not make the writer assert (needs >= 1024) or allocate something absurd.
+    static size_t sanitize(size_t numBytes){
+        const size_t lo = 4*1024;
+        const size_t hi = size_t(1) << 30;
+        return numBytes < lo ? lo : (numBytes > hi ? hi : numBytes);
+    }
+};
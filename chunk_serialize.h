@@ -0,0 +1,219 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <array>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <cstdint>
+#include <stdexcept>
+#include <type_traits>
+
+// Writes / reads whole values with file_writer_chunks and file_read_chunks, instead of
+// sequences of writeBytes() and read_Literal(). Decided at compile time, no runtime reflection:
+//
+//   trivially copyable (int, float, plain structs, arrays of them)   one copy of its bytes
+//   std::string                                                     uint64 length, then the chars
+//   std::vector<T>                                                  uint64 length, then the elements
+//                                                                   (one copy for all of them, if T is trivially copyable)
+//   std::array<T,N>,  std::pair,  std::tuple                        each element in turn
+//   your struct with a chunk_schema                                 each listed member in turn
+//                                                                   (neighbouring plain members: one copy for all of them)
+//
+// Nest them as you like, for example  std::vector<std::pair<std::string, std::array<float,3>>>
+//
+//   serialize(writer, value);            //or with writer.batch(), to lock only once
+//   deserialize(reader, value);
+//
+// For structs that aren't trivially copyable (they have strings, vectors...), list the members:
+//
+//   template<> struct chunk_schema<Person>{
+//       static constexpr auto members = std::make_tuple(&Person::name, &Person::age, &Person::tags);
+//   };
+//
+// NOTICE: trivially copyable values are stored as they are in memory (this machine's endianness and padding).
+// Pointers are rejected: their bytes mean nothing when read back.
+
+template<typename T>
+struct chunk_schema {};//specialize with 'members', see above
+
+
+namespace chunk_serialize_detail {
+    template<typename T, typename = void>
+    struct has_schema : std::false_type {};
+    template<typename T>
+    struct has_schema<T, std::void_t<decltype(chunk_schema<T>::members)>> : std::true_type {};
+
+    template<typename T> struct is_vector : std::false_type {};
+    template<typename T, typename A> struct is_vector<std::vector<T,A>> : std::true_type {};
+
+    template<typename T> struct is_string : std::false_type {};
+    template<typename C, typename Tr, typename A> struct is_string<std::basic_string<C,Tr,A>> : std::true_type {};
+
+    template<typename T> struct is_array : std::false_type {};
+    template<typename T, size_t N> struct is_array<std::array<T,N>> : std::true_type {};
+
+    template<typename T> struct is_tuple : std::false_type {};
+    template<typename... Ts> struct is_tuple<std::tuple<Ts...>> : std::true_type {};
+    template<typename A, typename B> struct is_tuple<std::pair<A,B>> : std::true_type {};
+
+    template<typename T>
+    constexpr bool is_bulk =  std::is_trivially_copyable_v<T>  &&  !std::is_pointer_v<T>  &&  !has_schema<T>::value;
+
+    template<typename T>
+    constexpr void reject(){
+        static_assert(!std::is_pointer_v<T>, "pointers can't be serialized");
+        static_assert(sizeof(T) == 0, "no serialization for this type: make it trivially copyable, or give it a chunk_schema");
+    }
+
+    // Listed members that are plain bytes and sit right after each other in memory (no padding
+    // between them) are copied at once, instead of one writeBytes() / read_rawData() each.
+    // Same bytes in the file either way.
+    template<typename Ptr>
+    struct bulk_run {
+        Ptr begin = nullptr;
+        size_t numBytes = 0;
+
+        // True if 'm' was appended to the run. Else, flush the run and start a new one at 'm'.
+        template<typename M>
+        bool extend(M& m){
+            if(numBytes > 0  &&  begin + numBytes == (Ptr)&m){  numBytes += sizeof(M);  return true;  }
+            return false;
+        }
+    };
+
+    template<typename T> struct is_vector_bool : std::false_type {};
+    template<typename A> struct is_vector_bool<std::vector<bool,A>> : std::true_type {};
+
+    template<typename T>
+    constexpr void reject_vector_bool(){
+        static_assert(!is_vector_bool<T>::value, "std::vector<bool> packs bits and has no data(): use std::vector<uint8_t>");
+    }
+
+    // A corrupted length must not make us allocate terabytes.
+    template<typename Reader>
+    void check_length(Reader& r,  uint64_t length,  size_t minBytesPerElement){
+        if(length > r.remainingBytes_total() / (minBytesPerElement ? minBytesPerElement : 1)){
+            throw std::runtime_error("deserialize(): length " + std::to_string(length) + " is more than the rest of the file");
+        }
+    }
+}
+
+
+template<typename Writer,  typename T>
+void serialize(Writer& w,  const T& value){
+    using namespace chunk_serialize_detail;
+
+    if constexpr (has_schema<T>::value){
+        bulk_run<const char*> run;
+        auto flush = [&]{  if(run.numBytes > 0){  w.writeBytes(run.begin, run.numBytes);  run.numBytes = 0;  }  };
+        auto one = [&](const auto& m){
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (is_bulk<M>){
+                if(run.extend(m)){ return; }
+                flush();
+                run.begin = (const char*)&m;
+                run.numBytes = sizeof(M);
+            }else{
+                flush();
+                serialize(w, m);
+            }
+        };
+        std::apply([&](auto... member){ (one(value.*member), ...); },  chunk_schema<T>::members);
+        flush();
+    }
+    else if constexpr (is_bulk<T>){
+        w.writeBytes(&value, sizeof(T));
+    }
+    else if constexpr (is_string<T>::value){
+        const uint64_t length = value.size();
+        w.writeBytes(&length, sizeof(length));
+        w.writeBytes(value.data(), length * sizeof(typename T::value_type));
+    }
+    else if constexpr (is_vector_bool<T>::value){
+        reject_vector_bool<T>();
+    }
+    else if constexpr (is_vector<T>::value){
+        using E = typename T::value_type;
+        const uint64_t length = value.size();
+        w.writeBytes(&length, sizeof(length));
+        if constexpr (is_bulk<E>){
+            w.writeBytes(value.data(), length * sizeof(E));
+        }else{
+            for(const E& e : value){ serialize(w, e); }
+        }
+    }
+    else if constexpr (is_array<T>::value){
+        for(const auto& e : value){ serialize(w, e); }
+    }
+    else if constexpr (is_tuple<T>::value){
+        std::apply([&](const auto&... e){ (serialize(w, e), ...); },  value);
+    }
+    else{
+        reject<T>();
+    }
+}
+
+
+template<typename Reader,  typename T>
+void deserialize(Reader& r,  T& value){
+    using namespace chunk_serialize_detail;
+
+    if constexpr (has_schema<T>::value){
+        bulk_run<char*> run;
+        auto flush = [&]{  if(run.numBytes > 0){  r.read_rawData(run.begin, run.numBytes);  run.numBytes = 0;  }  };
+        auto one = [&](auto& m){
+            using M = std::decay_t<decltype(m)>;
+            if constexpr (is_bulk<M>){
+                if(run.extend(m)){ return; }
+                flush();
+                run.begin = (char*)&m;
+                run.numBytes = sizeof(M);
+            }else{
+                flush();
+                deserialize(r, m);
+            }
+        };
+        std::apply([&](auto... member){ (one(value.*member), ...); },  chunk_schema<T>::members);
+        flush();
+    }
+    else if constexpr (is_bulk<T>){
+        r.read_rawData((char*)&value, sizeof(T));
+    }
+    else if constexpr (is_string<T>::value){
+        uint64_t length = 0;
+        r.read_rawData((char*)&length, sizeof(length));
+        check_length(r, length, sizeof(typename T::value_type));
+        value.resize(length);
+        r.read_rawData((char*)value.data(), length * sizeof(typename T::value_type));
+    }
+    else if constexpr (is_vector_bool<T>::value){
+        reject_vector_bool<T>();
+    }
+    else if constexpr (is_vector<T>::value){
+        using E = typename T::value_type;
+        uint64_t length = 0;
+        r.read_rawData((char*)&length, sizeof(length));
+        if constexpr (is_bulk<E>){
+            check_length(r, length, sizeof(E));
+            value.resize(length);
+            r.read_rawData((char*)value.data(), length * sizeof(E));
+        }else{
+            check_length(r, length, 1);//every element takes at least a byte
+            value.resize(length);
+            for(E& e : value){ deserialize(r, e); }
+        }
+    }
+    else if constexpr (is_array<T>::value){
+        for(auto& e : value){ deserialize(r, e); }
+    }
+    else if constexpr (is_tuple<T>::value){
+        std::apply([&](auto&... e){ (deserialize(r, e), ...); },  value);
+    }
+    else{
+        reject<T>();
+    }
+}
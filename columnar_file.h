@@ -0,0 +1,243 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <future>
+#include <cstdint>
+#include <stdexcept>
+#include "file_write_chunks.h"
+#include "file_read_chunks.h"
+#include "memory_backends.h"
+#include "chunk_serialize.h"
+
+// Columnar file: each column is stored in its own chunks, so a reader that needs
+// 3 of 40 columns loads only those 3 (with positional reads), instead of the entire file.
+//
+// Layout:
+//   [column chunks, in the order they filled up]  [footer]  [footer offset: uint64]  [magic: uint64]
+// The footer lists every column: its name, and the offset and size of each of its chunks.
+//
+//   columnar_writer w;
+//   w.beginWrite("t.col", {"time", "price", "qty"});
+//   w.write_Value(0, time);   w.write_Value(1, price);   w.write_Value(2, qty);    ...
+//   w.completeWrite();
+//
+//   columnar_reader r;
+//   r.open("t.col");
+//   std::vector<double> prices;
+//   r.read_Column(r.column_index("price"), prices);
+//
+// A value given to write_Value() is never split between two chunks of its column.
+// The writer isn't meant to be used from several threads at once.
+
+struct columnar_footer {
+    struct column {
+        std::string name;
+        std::vector<uint64_t> chunkOffsets;//in the file
+        std::vector<uint64_t> chunkBytes;
+    };
+    std::vector<column> columns;
+
+    static constexpr uint64_t k_magic = 0x31304C4F434B4843ull;//"CHKCOL01"
+};
+
+template<> struct chunk_schema<columnar_footer::column>{
+    static constexpr auto members = std::make_tuple(&columnar_footer::column::name,
+                                                    &columnar_footer::column::chunkOffsets,
+                                                    &columnar_footer::column::chunkBytes);
+};
+template<> struct chunk_schema<columnar_footer>{
+    static constexpr auto members = std::make_tuple(&columnar_footer::columns);
+};
+
+
+
+template<typename Backend = default_io_backend>
+class basic_columnar_writer {
+public:
+    // columnChunkBytes: each column collects this much in RAM, then it becomes one chunk in the file.
+    // Bigger chunks mean fewer seeks when a column is read back, but more RAM per column.
+    basic_columnar_writer(size_t columnChunkBytes = 1024*1024)
+        :_columnChunkBytes(columnChunkBytes){
+        if(columnChunkBytes == 0){ throw std::runtime_error("columnar_writer: columnChunkBytes must be above 0"); }
+    }
+
+    void beginWrite(const std::string& path_file_with_exten,  const std::vector<std::string>& columnNames){
+        _footer.columns.clear();
+        _pending.clear();
+        for(const std::string& name : columnNames){
+            _footer.columns.push_back({ name, {}, {} });
+            _pending.emplace_back();
+            _pending.back().reserve(_columnChunkBytes);
+        }
+        //NOTICE: starting size 0. The file grows as we write, so it ends right after the footer.
+        _file.beginWrite(path_file_with_exten, 0);
+        _offset = 0;
+    }
+
+
+    template<typename T>
+    void write_Value(size_t col,  const T& value){
+        static_assert(std::is_trivially_copyable_v<T>, "only plain bytes can be written");
+        std::vector<unsigned char>& p = _pending.at(col);
+        if(p.size() + sizeof(T) > _columnChunkBytes  &&  !p.empty()){ flush_column(col); }
+        const unsigned char* b = (const unsigned char*)&value;
+        p.insert(p.end(), b, b + sizeof(T));
+    }
+
+    // Appends to the column. Can be split between two chunks of the column.
+    void writeBytes(size_t col,  const void* bytes,  size_t numBytes){
+        std::vector<unsigned char>& p = _pending.at(col);
+        const unsigned char* b = (const unsigned char*)bytes;
+        while(numBytes > 0){
+            const size_t numFit = std::min(numBytes,  _columnChunkBytes - std::min(p.size(), _columnChunkBytes));
+            p.insert(p.end(), b, b + numFit);
+            b += numFit;
+            numBytes -= numFit;
+            if(p.size() >= _columnChunkBytes){ flush_column(col); }
+        }
+    }
+
+
+    // Stores what's left of every column, then the footer.
+    void completeWrite(){
+        for(size_t c=0; c<_pending.size(); ++c){
+            if(!_pending[c].empty()){ flush_column(c); }
+        }
+        const uint64_t footerOffset = _offset;
+        serialize(_file, _footer);
+        _file.write_Literal(footerOffset);
+        _file.write_Literal(columnar_footer::k_magic);
+        _file.completeWrite();
+    }
+
+
+private:
+    void flush_column(size_t col){
+        std::vector<unsigned char>& p = _pending[col];
+        _footer.columns[col].chunkOffsets.push_back(_offset);
+        _footer.columns[col].chunkBytes.push_back(p.size());
+        _file.writeBytes(p.data(), p.size());
+        _offset += p.size();
+        p.clear();
+    }
+
+
+private:
+    const size_t _columnChunkBytes;
+    basic_file_writer_chunks<Backend> _file;
+    columnar_footer _footer;
+    std::vector<std::vector<unsigned char>> _pending;//per column, not yet in the file
+    uint64_t _offset = 0;//where the next chunk goes in the file. NOTICE: not numBytesStored_soFar(), it counts every file
+};
+
+
+
+template<typename Backend = default_io_backend>
+class basic_columnar_reader {
+public:
+    //NOTICE: chunk size 0, because we only use positional reads. No chunk buffers are allocated.
+    basic_columnar_reader() : _file(0) {}
+
+    void open(const std::string& path_file_with_exten){
+        _file.BeginReadAt(path_file_with_exten);
+        const size_t fileBytes = _file.fileByteSize();
+        if(fileBytes < 2*sizeof(uint64_t)){ throw std::runtime_error("not a columnar file: " + path_file_with_exten); }
+
+        uint64_t tail[2];//footer offset, magic
+        _file.read_rawData_at(fileBytes - sizeof(tail), (char*)tail, sizeof(tail));
+        if(tail[1] != columnar_footer::k_magic  ||  tail[0] > fileBytes - sizeof(tail)){
+            throw std::runtime_error("not a columnar file: " + path_file_with_exten);
+        }
+        std::vector<unsigned char> bytes(fileBytes - sizeof(tail) - tail[0]);
+        _file.read_rawData_at(tail[0], (char*)bytes.data(), bytes.size());
+
+        memory_read_chunks footerReader;
+        footerReader.BeginRead(bytes.data(), bytes.size());
+        _footer = columnar_footer();
+        deserialize(footerReader, _footer);
+    }
+
+    void close(){ _file.EndRead(); }
+
+
+    size_t numColumns()const{ return _footer.columns.size(); }
+    const std::string& columnName(size_t col)const{ return _footer.columns.at(col).name; }
+
+    // Throws if there is no such column.
+    size_t column_index(std::string_view name)const{
+        for(size_t c=0; c<_footer.columns.size(); ++c){
+            if(_footer.columns[c].name == name){ return c; }
+        }
+        throw std::runtime_error("no column named " + std::string(name));
+    }
+
+    size_t columnBytes(size_t col)const{
+        size_t total = 0;
+        for(uint64_t n : _footer.columns.at(col).chunkBytes){ total += n; }
+        return total;
+    }
+
+
+    // Loads the entire column into 'dst', which must have room for columnBytes(col).
+    // One positional read per chunk, straight into 'dst'.
+    void read_Column(size_t col,  void* dst){
+        const columnar_footer::column& c = _footer.columns.at(col);
+        char* out = (char*)dst;
+        for(size_t i=0; i<c.chunkOffsets.size(); ++i){
+            _file.read_rawData_at(c.chunkOffsets[i], out, c.chunkBytes[i]);
+            out += c.chunkBytes[i];
+        }
+    }
+
+    template<typename T>
+    void read_Column(size_t col,  std::vector<T>& output){
+        static_assert(std::is_trivially_copyable_v<T>, "only plain bytes can be read");
+        const size_t numBytes = columnBytes(col);
+        if(numBytes % sizeof(T) != 0){ throw std::runtime_error("column " + columnName(col) + " isn't made of this type"); }
+        output.resize(numBytes / sizeof(T));
+        read_Column(col, output.data());
+    }
+
+
+    // Gives every chunk of the column to  fn(const unsigned char* bytes, size_t numBytes)
+    // The next chunk is loaded while 'fn' works on the current one.
+    template<typename Fn>
+    void for_each_chunk(size_t col,  Fn&& fn){
+        const columnar_footer::column& c = _footer.columns.at(col);
+        if(c.chunkOffsets.empty()){ return; }
+        std::vector<unsigned char> curr, next;
+        auto load = [&](size_t i,  std::vector<unsigned char>& into){
+            into.resize(c.chunkBytes[i]);
+            _file.read_rawData_at(c.chunkOffsets[i], (char*)into.data(), into.size());
+        };
+        load(0, curr);
+        for(size_t i=0; i<c.chunkOffsets.size(); ++i){
+            std::future<void> loading;
+            if(i+1 < c.chunkOffsets.size()){
+                loading = std::async(std::launch::async, [&, i]{ load(i+1, next); });
+            }
+            try{
+                fn((const unsigned char*)curr.data(), curr.size());
+            }catch(...){
+                if(loading.valid()){ loading.wait(); }
+                throw;
+            }
+            if(loading.valid()){ loading.get(); }
+            std::swap(curr, next);
+        }
+    }
+
+
+private:
+    basic_file_read_chunks<Backend> _file;
+    columnar_footer _footer;
+};
+
+
+using columnar_writer = basic_columnar_writer<default_io_backend>;
+using columnar_reader = basic_columnar_reader<default_io_backend>;
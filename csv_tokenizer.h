@@ -0,0 +1,255 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#endif
+#if defined(_MSC_VER)
+    #include <intrin.h>
+#endif
+
+// Splits delimited text (CSV, TSV, ...) into rows of fields, reading from file_read_chunks
+// (or any basic_file_read_chunks, including memory_read_chunks).
+//
+//   file_read_chunks reader;
+//   reader.BeginRead("data.csv");
+//   csv_tokenizer csv(reader);        // csv_tokenizer tsv(reader, '\t');
+//   std::vector<std::string_view> fields;
+//   while(csv.read_Row(fields)){
+//       ...fields[0], fields[1]...
+//   }
+//
+// Fields are views into the reader's chunk. They are only valid until the next read_Row().
+// A row that crosses into the next chunk is copied once, into a buffer kept by the tokenizer.
+//
+// Quoting:  "a,b" is one field,  "say ""hi""" is  say "hi"
+// A quote that is not at the start of a field is just a character.
+// Text between the closing quote and the delimiter is kept as it is:  "ab"c  is  abc  (like Python's csv).
+// Line breaks are \n or \r\n, and can be inside quoted fields.
+//
+// The chunk is examined 64 bytes at a time: a bitmask of delimiters, quotes and newlines
+// (AVX2 compares if compiled with -mavx2, plain loop otherwise), then only the set bits are visited.
+template<typename Reader>
+class csv_tokenizer {
+public:
+    csv_tokenizer(Reader& reader,  char delimiter = ',',  char quote = '"')
+        :_reader(reader),  _delim(delimiter),  _quote(quote){
+    }
+
+    // Returns false once there are no more rows.
+    bool read_Row(std::vector<std::string_view>& fields){
+        fields.clear();
+        _bounds.clear();
+        _row.clear();
+        _carried = 0;
+        reset_field(0);
+
+        //the previous row, which is still in the chunk (its views were valid until now)
+        if(_pendingSkip > 0){
+            _reader.skip_in_currBuff(_pendingSkip);
+            _pendingSkip = 0;
+        }
+
+        while(_reader.HasMoreForRead()){
+            const char* p =  (const char*)_reader.currBuff_data();
+            const size_t n = _reader.remainingBytes_in_currBuff();
+            if(n == 0){ break; }
+
+            const size_t rowEnd = scan(p, n);
+            if(rowEnd != k_none){
+                if(_carried == 0){
+                    //the entire row is in this chunk. Don't copy it.
+                    _pendingSkip = rowEnd + 1;
+                    make_views(p, fields);
+                }else{
+                    _row.append(p, rowEnd);
+                    _reader.skip_in_currBuff(rowEnd + 1);
+                    make_views(_row.data(), fields);
+                }
+                ++_numRows;
+                return true;
+            }
+            //the row continues in the next chunk:
+            _row.append(p, n);
+            _carried += n;
+            _reader.skip_in_currBuff(n);
+        }
+
+        //the file ended without a line break after the last row:
+        if(_carried == 0){ return false; }
+        end_field(_carried);
+        make_views(_row.data(), fields);
+        ++_numRows;
+        return true;
+    }
+
+    // How many rows were given by read_Row()
+    size_t numRows()const{ return _numRows; }
+
+
+private:
+    static constexpr size_t k_none = std::numeric_limits<size_t>::max();
+
+    // A field is its quoted part, then the text after the closing quote.
+    // An unquoted field has only the latter.
+    struct field_bounds {
+        size_t begin;//from the start of the row
+        size_t end;
+        size_t tailBegin;//  "ab"c  Empty for most quoted fields.
+        size_t tailEnd;
+        bool unescape;//has "" inside
+    };
+
+
+    // Returns where the row ends in 'p' (its \n), or k_none if it continues after 'p'.
+    size_t scan(const char* p,  size_t n){
+        for(size_t blk = 0;  blk < n;  blk += 64){
+            const size_t len = n - blk < 64 ? n - blk : 64;
+            uint64_t mask =  len == 64 ? structural_mask(p + blk)
+                                       : structural_mask_scalar(p + blk, len);
+            while(mask != 0){
+                const size_t i = blk + count_trailing_zeros(mask);
+                mask &= mask - 1;
+                const size_t at = _carried + i;//from the start of the row
+                const char c = p[i];
+
+                if(_inQuotes){
+                    //delimiters and line breaks are just text in here
+                    if(c == _quote){ _inQuotes = false;  _closeQuote = at; }
+                    continue;
+                }
+                if(c == _quote){
+                    if(at == _fieldStart){  _inQuotes = true;  _fieldQuoted = true;  }
+                    else if(_fieldQuoted  &&  at == _closeQuote + 1){  _inQuotes = true;  _unescape = true;  }//it was ""
+                    //else: a quote in the middle of a field is just a character.
+                    continue;
+                }
+                end_field(at);
+                if(c == '\n'){ return i; }
+                reset_field(at + 1);
+            }
+        }
+        return k_none;
+    }
+
+
+    void end_field(size_t at){
+        if(_fieldQuoted){
+            const size_t end =  _inQuotes ? at : _closeQuote;//unterminated quote: take everything
+            const size_t tail = _inQuotes ? at : _closeQuote + 1;
+            _bounds.push_back({ _fieldStart + 1,  end,  tail,  at,  _unescape });
+        }else{
+            _bounds.push_back({ _fieldStart,  _fieldStart,  _fieldStart,  at,  false });
+        }
+    }
+
+    void reset_field(size_t start){
+        _fieldStart = start;
+        _fieldQuoted = false;
+        _inQuotes = false;
+        _unescape = false;
+        _closeQuote = k_none - 1;
+    }
+
+
+    void make_views(const char* rowBegin,  std::vector<std::string_view>& fields){
+        //  a,b\r\n   the \r belongs to the line break, not to the field (unless it's inside quotes).
+        field_bounds& last = _bounds.back();
+        if(last.tailEnd > last.tailBegin  &&  rowBegin[last.tailEnd - 1] == '\r'){ --last.tailEnd; }
+
+        //reserve first, so views into '_unescaped' are not invalidated by its growth:
+        size_t numUnescaped = 0;
+        for(const field_bounds& b : _bounds){
+            if(needs_copy(b)){ numUnescaped += (b.end - b.begin) + (b.tailEnd - b.tailBegin); }
+        }
+        _unescaped.clear();
+        _unescaped.reserve(numUnescaped);
+
+        for(const field_bounds& b : _bounds){
+            if(!needs_copy(b)){
+                if(b.tailEnd > b.tailBegin){ fields.emplace_back(rowBegin + b.tailBegin,  b.tailEnd - b.tailBegin); }
+                else{                        fields.emplace_back(rowBegin + b.begin,  b.end - b.begin); }
+                continue;
+            }
+            const size_t from = _unescaped.size();
+            for(size_t i = b.begin;  i < b.end;  ++i){
+                _unescaped.push_back(rowBegin[i]);
+                if(b.unescape  &&  rowBegin[i] == _quote  &&  i+1 < b.end  &&  rowBegin[i+1] == _quote){ ++i; }
+            }
+            _unescaped.append(rowBegin + b.tailBegin,  b.tailEnd - b.tailBegin);
+            fields.emplace_back(_unescaped.data() + from,  _unescaped.size() - from);
+        }
+    }
+
+    // "" inside, or text after the closing quote: the field isn't one piece of the row.
+    static bool needs_copy(const field_bounds& b){
+        return b.unescape  ||  (b.end > b.begin  &&  b.tailEnd > b.tailBegin);
+    }
+
+
+    // bit i is set if p[i] is a delimiter, quote or \n
+    uint64_t structural_mask(const char* p)const{
+    #if defined(__AVX2__)
+        const __m256i d = _mm256_set1_epi8(_delim);
+        const __m256i q = _mm256_set1_epi8(_quote);
+        const __m256i nl = _mm256_set1_epi8('\n');
+        auto half = [&](const char* h){
+            const __m256i v = _mm256_loadu_si256((const __m256i*)h);
+            const __m256i hits = _mm256_or_si256( _mm256_or_si256(_mm256_cmpeq_epi8(v, d),  _mm256_cmpeq_epi8(v, q)),
+                                                  _mm256_cmpeq_epi8(v, nl) );
+            return (uint64_t)(uint32_t)_mm256_movemask_epi8(hits);
+        };
+        return half(p) | (half(p + 32) << 32);
+    #else
+        return structural_mask_scalar(p, 64);
+    #endif
+    }
+
+    uint64_t structural_mask_scalar(const char* p,  size_t len)const{
+        uint64_t mask = 0;
+        for(size_t i=0; i<len; ++i){
+            const bool hit = p[i] == _delim  ||  p[i] == _quote  ||  p[i] == '\n';
+            mask |= (uint64_t)hit << i;
+        }
+        return mask;
+    }
+
+    static unsigned count_trailing_zeros(uint64_t mask){
+    #if defined(_MSC_VER)
+        unsigned long ix;
+        _BitScanForward64(&ix, mask);
+        return (unsigned)ix;
+    #else
+        return (unsigned)__builtin_ctzll(mask);
+    #endif
+    }
+
+
+private:
+    Reader& _reader;
+    const char _delim;
+    const char _quote;
+
+    size_t _pendingSkip = 0;//bytes of the previous row, still to be skipped in the reader
+    size_t _numRows = 0;
+
+    //state of the row being scanned. Carried across chunks:
+    std::string _row;//only for a row that crosses chunks
+    size_t _carried = 0;//bytes of this row, from the previous chunks
+    std::vector<field_bounds> _bounds;
+    size_t _fieldStart = 0;
+    size_t _closeQuote = 0;
+    bool _fieldQuoted = false;
+    bool _inQuotes = false;
+    bool _unescape = false;
+
+    std::string _unescaped;//fields that had "" inside
+};
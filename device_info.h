@@ -0,0 +1,156 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <mutex>
+#include <map>
+#include <cstdint>
+#include <algorithm>
+
+#if defined(__linux__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/vfs.h>
+#endif
+
+// What kind of storage a file lives on, and the chunk settings that suit it.
+// Used by file_read_chunks / file_writer_chunks when they are asked to pick the
+// chunk size themselves (size 0, which is what you get when there is no chunk_profile).
+//
+// On Linux it's found via statx() of the file, and  /sys/dev/block/<major>:<minor>/queue
+// (the same as /sys/block/<disk>/queue). Elsewhere, 'unknown' with the old 1MB default.
+struct device_info {
+    enum class Kind { unknown,  rotational,  solid_state,  memory };
+
+    Kind kind = Kind::unknown;
+    size_t logicalBlockSize = 512;
+    size_t physicalBlockSize = 4096;
+    size_t optimalIoSize = 0;//0 if the device doesn't say
+    bool directIoPossible = false;//O_DIRECT can be used on this file system
+    size_t directIoMemAlign = 0;//alignment that O_DIRECT needs for memory buffers (0 if unknown)
+
+    //suggestions:
+    size_t chunkBytes = 1024*1024;
+    size_t alignment = 16;//of the chunk buffers in memory. Logical block size, so O_DIRECT could use them.
+
+
+    // 'path' can be a file, or a file that doesn't exist yet (then its directory is examined).
+    // Results are cached per device, so after the first file on a device this is one statx call.
+    static device_info probe(const std::string& path){
+        device_info info;
+    #if defined(__linux__)
+        std::filesystem::path p(path);
+        struct statx stx{};
+        unsigned int mask = STATX_TYPE;
+    #ifdef STATX_DIOALIGN
+        mask |= STATX_DIOALIGN;
+    #endif
+        if(::statx(AT_FDCWD, p.c_str(), 0, mask, &stx) != 0){
+            //not created yet, so examine the directory it will be in:
+            p = p.has_parent_path() ? p.parent_path() : std::filesystem::path(".");
+            if(::statx(AT_FDCWD, p.c_str(), 0, mask, &stx) != 0){ return info; }
+        }
+        const uint64_t devKey = ((uint64_t)stx.stx_dev_major << 32) | stx.stx_dev_minor;
+        const bool isFile = S_ISREG(stx.stx_mode);
+
+        {
+            std::lock_guard lck(cache_mutex());
+            auto it = cache().find(devKey);
+            if(it != cache().end()){
+                //directories can't tell about O_DIRECT. So complete it once we see a real file:
+                if(!it->second._directIoChecked  &&  isFile){  
+                    it->second.check_direct_io(p, stx);
+                    it->second.suggest();
+                }
+                return it->second;
+            }
+        }
+
+        struct statfs sfs{};
+        const bool isMemoryFs =  ::statfs(p.c_str(), &sfs) == 0
+                                 &&  (sfs.f_type == 0x01021994 /*TMPFS_MAGIC*/  ||  sfs.f_type == 0x858458f6 /*RAMFS_MAGIC*/);
+        if(isMemoryFs){
+            info.kind = Kind::memory;
+        }else{
+            const std::string queue = queue_dir(stx.stx_dev_major, stx.stx_dev_minor);
+            if(!queue.empty()){
+                const size_t rotational = read_number(queue + "/rotational", 0);
+                info.kind = rotational ? Kind::rotational : Kind::solid_state;
+                info.logicalBlockSize  = read_number(queue + "/logical_block_size",  info.logicalBlockSize);
+                info.physicalBlockSize = read_number(queue + "/physical_block_size", info.physicalBlockSize);
+                info.optimalIoSize     = read_number(queue + "/optimal_io_size", 0);
+            }
+        }
+        if(isFile){ info.check_direct_io(p, stx); }
+
+        info.suggest();
+        std::lock_guard lck(cache_mutex());
+        cache()[devKey] = info;
+    #else
+        (void)path;
+    #endif
+        return info;
+    }
+
+private:
+    void suggest(){
+        switch(kind){
+            //a seek costs milliseconds, so move a lot of bytes per request.
+            case Kind::rotational:  chunkBytes = 8*1024*1024;  break;
+            //NVMe/SSD: saturated by ~1MB requests, unless the device asks for more.
+            case Kind::solid_state: chunkBytes = std::max<size_t>(1024*1024, optimalIoSize);  break;
+            //tmpfs: it's a memcpy. Small chunks stay in CPU cache while we consume them.
+            case Kind::memory:      chunkBytes = 256*1024;  break;
+            default:                chunkBytes = 1024*1024;  break;
+        }
+        alignment = std::max<size_t>(16,  std::max(logicalBlockSize, directIoMemAlign));
+        //chunks must be whole blocks, otherwise every chunk boundary splits a block in two requests:
+        chunkBytes = (chunkBytes + physicalBlockSize - 1) / physicalBlockSize * physicalBlockSize;
+    }
+
+#if defined(__linux__)
+    void check_direct_io(const std::filesystem::path& file,  const struct statx& stx){
+        _directIoChecked = true;
+    #ifdef STATX_DIOALIGN
+        if(stx.stx_mask & STATX_DIOALIGN){
+            directIoPossible = stx.stx_dio_mem_align != 0;
+            directIoMemAlign = stx.stx_dio_mem_align;
+            return;
+        }
+    #endif
+        //older kernels don't report it, so just try:
+        const int fd = ::open(file.c_str(), O_RDONLY | O_DIRECT | O_CLOEXEC);
+        if(fd >= 0){
+            directIoPossible = true;
+            directIoMemAlign = logicalBlockSize;
+            ::close(fd);
+        }
+    }
+
+    // A partition doesn't have its own 'queue', its disk does (one level up).
+    static std::string queue_dir(unsigned major, unsigned minor){
+        std::error_code ec;
+        const std::string dev = "/sys/dev/block/" + std::to_string(major) + ":" + std::to_string(minor);
+        if(std::filesystem::exists(dev + "/queue", ec)){ return dev + "/queue"; }
+        if(std::filesystem::exists(dev + "/../queue", ec)){ return dev + "/../queue"; }
+        return "";
+    }
+
+    static size_t read_number(const std::string& file,  size_t fallback){
+        std::ifstream f(file);
+        size_t v = 0;
+        if(f >> v){ return v; }
+        return fallback;
+    }
+#endif
+
+    bool _directIoChecked = false;
+
+    static std::map<uint64_t, device_info>& cache(){ static std::map<uint64_t, device_info> c; return c; }
+    static std::mutex& cache_mutex(){ static std::mutex m; return m; }
+};
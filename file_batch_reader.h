@@ -0,0 +1,227 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <map>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <stdexcept>
+#include <algorithm>
+#include "io_backends.h"
+
+// Reads lots of small files. With file_read_chunks you open them one after another,
+// so you wait for every open() in turn. On cold metadata or network disks, that waiting
+// is most of the time.
+//
+// Here, a pool of worker threads opens and reads many files at the same time. Each file is
+// given to your callback as a view of its entire contents, on the thread that called read_all():
+//
+//   file_batch_reader batch;
+//   batch.read_all(paths, [&](const file_batch_reader::file_view& v){
+//       if(!v.ok()){  ...v.error...  return; }
+//       memory_read_chunks r;   //same reading API as with a file (see memory_backends.h)
+//       r.BeginRead(v.data, v.size);
+//       ...
+//   });
+//
+// 'order::completion' gives files as soon as they are loaded (fastest).
+// 'order::list' gives them in the order of 'paths'.
+//
+// At most 'maxBytesInFlight' of loaded-but-not-yet-given files are kept in RAM.
+// The one you are waiting for in 'order::list' is always allowed, even if bigger.
+template<typename Backend = default_io_backend>
+class basic_file_batch_reader {
+public:
+    enum class order { completion,  list };
+
+    // Only valid during the callback. Copy the bytes if you need them after it.
+    struct file_view {
+        size_t index = 0;//in 'paths'
+        const std::string* path = nullptr;
+        const unsigned char* data = nullptr;
+        size_t size = 0;
+        std::string error;//empty if the file was read fine
+
+        bool ok()const{ return error.empty(); }
+    };
+
+    // numThreads 0:  two per hardware thread, because they mostly wait on open() and read().
+    basic_file_batch_reader(size_t numThreads = 0,  size_t maxBytesInFlight = 256*1024*1024)
+        :_numThreads(numThreads != 0 ? numThreads : 2*std::max(1u, std::thread::hardware_concurrency())),
+         _maxBytesInFlight(maxBytesInFlight){
+    }
+
+
+    // Blocks until every file was given to 'fn',  fn(const file_view&).
+    // If 'fn' throws, the remaining files are abandoned and the exception is re-thrown here.
+    template<typename Fn>
+    void read_all(const std::vector<std::string>& paths,  Fn&& fn,  order ord = order::completion){
+        if(paths.empty()){ return; }
+
+        _paths = &paths;
+        _order = ord;
+        _nextIx = 0;
+        _nextToGive = 0;
+        _bytesInFlight = 0;
+        _stop = false;
+        _loaded.clear();
+
+        std::vector<std::thread> workers;
+        const size_t numThreads = std::min(_numThreads, paths.size());
+        for(size_t i=0; i<numThreads; ++i){
+            workers.emplace_back([this]{ worker_loop(); });
+        }
+
+        try{
+            for(size_t numGiven=0; numGiven<paths.size(); ++numGiven){
+                Loaded l = wait_for_next();
+                file_view v;
+                v.index = l.index;
+                v.path = &paths[l.index];
+                v.data = l.bytes.data();
+                v.size = l.bytes.size();
+                v.error = std::move(l.error);
+                fn( (const file_view&)v );
+                give_back(std::move(l.bytes), l.budget);
+            }
+        }catch(...){
+            {
+                std::lock_guard lck(_mu);
+                _stop = true;
+            }
+            _cv_budget.notify_all();
+            for(std::thread& t : workers){ t.join(); }
+            throw;
+        }
+        for(std::thread& t : workers){ t.join(); }
+    }
+
+
+private:
+    struct Loaded {
+        size_t index = 0;
+        std::vector<unsigned char> bytes;
+        std::string error;
+        size_t budget = 0;//taken from _bytesInFlight
+    };
+
+
+    void worker_loop(){
+        Backend io;//one per worker
+        for(;;){
+            const size_t ix = _nextIx.fetch_add(1);
+            if(ix >= _paths->size()){ return; }
+
+            Loaded l;
+            l.index = ix;
+            std::vector<unsigned char> buffer;
+            size_t numBytes = 0;
+            bool isOpen = false;
+            try{
+                isOpen = io.open_read((*_paths)[ix]);
+                if(isOpen){ numBytes = io.size(); }
+                else{ l.error = "couldn't open"; }
+            }catch(const std::exception& e){
+                l.error = e.what();
+            }
+
+            //NOTICE: the budget is taken even for failed files (0 bytes), so results arrive in one place.
+            if(!take_budget(ix, numBytes, buffer)){  io.close(); return;  }//stopping
+
+            if(isOpen && l.error.empty()){
+                buffer.resize(numBytes);
+                const size_t got = numBytes > 0 ? io.read_at(buffer.data(), numBytes, 0) : 0;
+                if(got != numBytes){
+                    l.error = "short read: " + std::to_string(got) + " of " + std::to_string(numBytes) + " bytes";
+                    buffer.clear();
+                }
+            }
+            io.close();
+            l.bytes = std::move(buffer);
+            l.budget = numBytes;
+
+            {
+                std::lock_guard lck(_mu);
+                _loaded[ix] = std::move(l);
+            }
+            _cv_loaded.notify_one();
+        }
+    }
+
+
+    // Waits until there is room for 'numBytes' more, and gives a pooled buffer.
+    // Returns false if read_all() is abandoned.
+    bool take_budget(size_t ix,  size_t numBytes,  std::vector<unsigned char>& buffer){
+        std::unique_lock lck(_mu);
+        _cv_budget.wait(lck, [&]{
+            if(_stop){ return true; }
+            if(_bytesInFlight == 0  ||  _bytesInFlight + numBytes <= _maxBytesInFlight){ return true; }
+            //the consumer waits for this exact file. Everything else can't be given before it:
+            return _order == order::list  &&  ix == _nextToGive;
+        });
+        if(_stop){ return false; }
+        _bytesInFlight += numBytes;
+        if(!_pool.empty()){
+            buffer = std::move(_pool.back());
+            _pool.pop_back();
+        }
+        return true;
+    }
+
+
+    Loaded wait_for_next(){
+        std::unique_lock lck(_mu);
+        typename std::map<size_t, Loaded>::iterator it;
+        _cv_loaded.wait(lck, [&]{
+            if(_loaded.empty()){ return false; }
+            it = _order == order::list ? _loaded.find(_nextToGive) : _loaded.begin();
+            return it != _loaded.end();
+        });
+        Loaded l = std::move(it->second);
+        _loaded.erase(it);
+        ++_nextToGive;
+        lck.unlock();
+        _cv_budget.notify_all();//maybe the next file in the list was waiting for its turn
+        return l;
+    }
+
+
+    void give_back(std::vector<unsigned char>&& bytes,  size_t budget){
+        {
+            std::lock_guard lck(_mu);
+            _bytesInFlight -= budget;
+            if(_pool.size() < 2*_numThreads){
+                bytes.clear();
+                _pool.push_back(std::move(bytes));
+            }
+        }
+        _cv_budget.notify_all();
+    }
+
+
+private:
+    const size_t _numThreads;
+    const size_t _maxBytesInFlight;
+
+    const std::vector<std::string>* _paths = nullptr;
+    order _order = order::completion;
+    std::atomic<size_t> _nextIx = 0;//next path that a worker will take
+    size_t _nextToGive = 0;//how many were given to the callback
+    size_t _bytesInFlight = 0;//loaded (or being loaded), but not yet given back by the callback
+    bool _stop = false;
+
+    std::map<size_t, Loaded> _loaded;//by index, waiting for the callback
+    std::vector<std::vector<unsigned char>> _pool;//buffers to reuse for the next files
+
+    std::mutex _mu;
+    std::condition_variable _cv_loaded;//read_all() waits for a file
+    std::condition_variable _cv_budget;//workers wait for room in RAM
+};
+
+
+using file_batch_reader = basic_file_batch_reader<default_io_backend>;
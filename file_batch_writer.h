@@ -0,0 +1,204 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <stdexcept>
+#include <algorithm>
+#include "io_backends.h"
+
+// Writes lots of small, independent files. For millions of outputs, file_writer_chunks is
+// the wrong tool: every beginWrite() sets up buffers, resizes the file, and might start a thread.
+//
+// Here, any thread submits (path, bytes) jobs. A fixed set of worker threads takes them from
+// a queue several at a time, and does  open + write + close  for each one.
+// Copies of the bytes are kept in pooled buffers, so after a warm-up there are no allocations.
+//
+//   file_batch_writer batch;
+//   for(...){  batch.submit(path, bytes, numBytes);  }   //from any number of threads
+//   batch.flush();   //waits until everything is on disk, throws if some file failed
+//
+// submit() blocks while 'maxQueuedJobs' are already waiting, so a fast producer
+// can't fill all of RAM with pending files.
+//
+// Every file is created from scratch (truncated if it existed).
+template<typename Backend = default_io_backend>
+class basic_file_batch_writer {
+    struct Job {
+        std::string path;
+        std::vector<unsigned char> bytes;
+    };
+
+    basic_file_batch_writer(const basic_file_batch_writer& other) = delete;
+    basic_file_batch_writer& operator=(const basic_file_batch_writer& other) = delete;
+
+public:
+    // numThreads 0:  one per hardware thread. Files are mostly waiting on metadata
+    // (create/close), so more threads than cores is often faster on real disks.
+    basic_file_batch_writer(size_t numThreads = 0,  size_t maxQueuedJobs = 4096){
+        if(numThreads == 0){ numThreads = std::max(1u, std::thread::hardware_concurrency()); }
+        _maxQueuedJobs = std::max<size_t>(1, maxQueuedJobs);
+        for(size_t i=0; i<numThreads; ++i){
+            _workers.emplace_back([this]{ worker_loop(); });
+        }
+    }
+
+    // Writes whatever is still pending. Errors are lost at this point, call flush() to see them.
+    ~basic_file_batch_writer(){
+        {
+            std::lock_guard lck(_mu);
+            _stop = true;
+        }
+        _cv_jobs.notify_all();
+        for(std::thread& t : _workers){ t.join(); }
+    }
+
+
+    // Copies the bytes, so you can reuse your memory right away.
+    void submit(std::string path,  const void* bytes,  size_t numBytes){
+        std::unique_lock lck(_mu);
+        wait_for_space(lck);
+        Job j{ std::move(path),  take_pooled_buffer() };
+        j.bytes.assign((const unsigned char*)bytes,  (const unsigned char*)bytes + numBytes);
+        push(std::move(j), lck);
+    }
+
+    // Takes ownership of your vector, no copy.
+    void submit(std::string path,  std::vector<unsigned char>&& bytes){
+        std::unique_lock lck(_mu);
+        wait_for_space(lck);
+        push(Job{ std::move(path), std::move(bytes) },  lck);
+    }
+
+
+    // Blocks until every submitted file was written (or failed).
+    // Throws std::runtime_error describing the failures since the previous flush().
+    void flush(){
+        std::unique_lock lck(_mu);
+        _cv_idle.wait(lck, [this]{ return _queue.empty() && _numInFlight == 0; });
+
+        if(_errors.empty()){ return; }
+        std::string message = std::to_string(_errors.size()) + " file(s) failed in file_batch_writer, first: " + _errors.front();
+        _errors.clear();
+        throw std::runtime_error(message);
+    }
+
+    size_t numWritten()const{ std::lock_guard lck(_mu); return _numWritten; }
+    size_t numFailed()const{  std::lock_guard lck(_mu); return _numFailed; }
+
+
+private:
+    static constexpr size_t k_jobsPerBatch = 32;//how many jobs a worker takes per lock
+    static constexpr size_t k_maxPooledBytes = 1024*1024;//bigger buffers are freed, not pooled
+    static constexpr size_t k_maxPoolBytes_total = 32*1024*1024;//idle memory kept by the pool, all buffers together
+
+
+    void wait_for_space(std::unique_lock<std::mutex>& lck){
+        //NOTICE: mutex is already locked.
+        _cv_space.wait(lck, [this]{ return _queue.size() < _maxQueuedJobs; });
+    }
+
+    void push(Job&& j,  std::unique_lock<std::mutex>& lck){
+        //NOTICE: mutex is already locked.
+        _queue.push_back(std::move(j));
+        lck.unlock();
+        _cv_jobs.notify_one();
+    }
+
+    std::vector<unsigned char> take_pooled_buffer(){
+        //NOTICE: mutex is already locked.
+        if(_pool.empty()){ return {}; }
+        std::vector<unsigned char> b = std::move(_pool.back());
+        _pool.pop_back();
+        _pooledBytes -= b.capacity();
+        return b;
+    }
+
+
+    void worker_loop(){
+        Backend io;//one per worker, so workers never wait on each other's file
+        std::vector<Job> batch;
+        batch.reserve(k_jobsPerBatch);
+
+        for(;;){
+            {
+                std::unique_lock lck(_mu);
+                _cv_jobs.wait(lck, [this]{ return !_queue.empty() || _stop; });
+                if(_queue.empty()){ return; }//stopping, and nothing left
+
+                while(!_queue.empty()  &&  batch.size() < k_jobsPerBatch){
+                    batch.push_back(std::move(_queue.front()));
+                    _queue.pop_front();
+                }
+                _numInFlight += batch.size();
+            }
+            _cv_space.notify_all();
+
+            size_t numOk = 0;
+            std::vector<std::string> errors;
+            for(Job& j : batch){
+                try{
+                    write_one(io, j);
+                    ++numOk;
+                }catch(const std::exception& e){
+                    io.close();
+                    errors.push_back(j.path + ": " + e.what());
+                }
+            }
+
+            {
+                std::lock_guard lck(_mu);
+                for(Job& j : batch){
+                    const size_t cap = j.bytes.capacity();
+                    if(cap <= k_maxPooledBytes  &&  _pooledBytes + cap <= k_maxPoolBytes_total){
+                        j.bytes.clear();
+                        _pooledBytes += cap;
+                        _pool.push_back(std::move(j.bytes));
+                    }
+                }
+                _numWritten += numOk;
+                _numFailed += errors.size();
+                for(std::string& e : errors){ _errors.push_back(std::move(e)); }
+                _numInFlight -= batch.size();
+                if(_queue.empty() && _numInFlight == 0){ _cv_idle.notify_all(); }
+            }
+            batch.clear();
+        }
+    }
+
+
+    static void write_one(Backend& io,  const Job& j){
+        if(!io.open_write(j.path, true)){ throw std::runtime_error("couldn't open"); }
+        if(!j.bytes.empty()){ io.write_at(j.bytes.data(), j.bytes.size(), 0); }
+        io.close();
+    }
+
+
+private:
+    std::vector<std::thread> _workers;
+
+    std::deque<Job> _queue;
+    std::vector<std::vector<unsigned char>> _pool;//emptied buffers, ready for new jobs
+    size_t _pooledBytes = 0;//capacity of all buffers in '_pool'
+    size_t _maxQueuedJobs = 4096;
+    size_t _numInFlight = 0;//taken by workers, not finished yet
+    bool _stop = false;
+
+    size_t _numWritten = 0;
+    size_t _numFailed = 0;
+    std::vector<std::string> _errors;//since the last flush()
+
+    mutable std::mutex _mu;
+    std::condition_variable _cv_jobs;//workers wait for jobs
+    std::condition_variable _cv_space;//submit() waits for room in the queue
+    std::condition_variable _cv_idle;//flush() waits for everything to be done
+};
+
+
+using file_batch_writer = basic_file_batch_writer<default_io_backend>;
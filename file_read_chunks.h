@@ -7,7 +7,18 @@
 #include <filesystem>
 #include <functional>
 #include <thread>
+#include <string_view>
+#include <charconv>
+#include <algorithm>
 #include "RawData_Buff.h"
+#include "io_backends.h"
+#include "chunk_hooks.h"
+#include "chunk_profile.h"
+#include "device_info.h"
+#include "utf8_validate.h"
+#include "string_arena.h"
+#include "soa_column.h"
+#include "chunk_index.h"
 
 namespace fs = std::filesystem;
 
@@ -24,70 +35,224 @@ namespace fs = std::filesystem;
 // to provide the user with the requested data.
 //
 // See BeginRead()  
+// See BeginReadAt()  read_rawData_at()    <-- positional reads, when you know where your bytes are
+// See seek()  load_index()  lookup()  seekToRecord()    <-- continue from any offset, skip what the writer's index rules out
 // See HasMoreForRead()    <-- for example, could be used when in a loop
 // See EndRead()
 //
 // See read_rawData()      <-- for example, could be used when in a loop
+// See read_rawDatav()     <-- several destinations at once
 // See read_Literal()    <-- int, float, struct (shallow, no deep copies), etc.
 // See read_String()    <--ascii text, for example "hello, I am Igor"
+// See read_String_utf8()    <-- also checks that the text is valid UTF-8
+// See read_String(string_arena&)  read_String_arena()    <-- no allocation per string
+// See read_RecordsSoA()    <-- packed records into separate arrays per field
+// See read_AsciiInt()  read_AsciiDouble()    <-- numbers written as text, for example  -12.5e3
+// See skip_Whitespace()  skip_Chars()
+//
+// 'Hooks' lets you observe the internal events at compile time, see chunk_hooks.h
+// 'Backend' is where the bytes come from, see io_backends.h
+// Use 'file_read_chunks' for the default one.
+// If the backend is 'is_in_memory' there are no chunks at all: we read straight from its memory.
 
-class file_read_chunks{
+template<typename Backend,  typename Hooks = no_chunk_hooks>
+class basic_file_read_chunks{
 
 public:
-    file_read_chunks(size_t chunkBuffSize = 1024*1024 )
-        :_buff_a(chunkBuffSize),
-         _buff_b(chunkBuffSize){
+    // By default, uses the chunk size that suits this machine (see chunk_profile.h)
+    // chunkBuffSize 0:  pick it for the device of every file given to BeginRead() (see device_info.h)
+    basic_file_read_chunks(size_t chunkBuffSize = chunk_profile::get_default().read_chunkBytes )
+        :_buff_a(k_inMemory ? 0 : chunkBuffSize),
+         _buff_b(k_inMemory ? 0 : chunkBuffSize),
+         _isAutoChunkSize(chunkBuffSize == 0){
     }
 
-    ~file_read_chunks(){
-        if(_file.is_open()){ _file.close(); }
+    ~basic_file_read_chunks(){
+        EndRead();
     }
 
+    // For example, to configure it before BeginRead()
+    Backend& backend(){ return _io; }
+
+    // Optional. Records chunk loads and the waits for them (see chunk_io_trace.h). 
+    // nullptr to stop recording. Don't change it during reading.
+    void set_tracer(chunk_io_tracer* tracer){ _events.set_tracer(tracer); }
+
+    Hooks& hooks(){ return _events.hooks(); }
+
 public:
     // fileName_with_exten:  for example,  myFile.someExtension
     void BeginRead(const std::string& fileName_with_exten){
         EndRead();//just in case
         
-        fs::path p(fileName_with_exten);
-        _file.open(p, std::ios::binary);
-
-        if (_file.is_open() == false){
+        if (_io.open_read(fileName_with_exten) == false){
             std::string message = std::string("file_read_chunks() could not open filePath: ") + fileName_with_exten;
             throw std::runtime_error(message);
             return;
         }
         
-        _chunkSize =     _buff_a.totalAlocatedSize();
-        _fileByteSize =  fs::file_size(p);//throws exception if path doesn't exist. 
-        _numChunks =     (int)(_fileByteSize / _chunkSize);
-        _lastChunkSize = _fileByteSize % _chunkSize; //in case there are some left overs 
+        _fileByteSize =  _io.size();
+
+        if constexpr (k_inMemory){
+            //everything is already in RAM, so it's one big chunk. No threads, no copies.
+            _buff_a.set_view(_io.data(), _fileByteSize);
+            _chunkSize = _lastChunkSize = _fileByteSize;
+            _numChunks = 1;
+            _ix_inEntireFile = 0;
+            _isA = true;
+            _readingChunk_id = 0;
+            return;
+        }
+
+        _path = fileName_with_exten;
+        layout_chunks();
         _ix_inEntireFile = 0;
-        // 'numChunks' includes the last chunk.
-        // If there was no remainder, then the last chunk is normal.
-        // Make sure to set it, because it will be used on last iter:
-        if(_lastChunkSize > 0){ _numChunks++; }
-        else{ _lastChunkSize = _chunkSize; }
+        _isA = true;
+        _readingChunk_id = 0;
 
-        bool willLoadIntoLastChunk = _numChunks==1;
-        fetchIntoBuff_thrd(true, willLoadIntoLastChunk); // true: fill _buff_A (doesn't block the thread)
-        
-        if (_numChunks>1){
-            willLoadIntoLastChunk = _numChunks==2;
-            //at the start of the function it waits for the _buff_A to fill. (blocks the thread)
-            fetchIntoBuff_thrd(false, willLoadIntoLastChunk);
-        }else {
-            if (_loadThread.joinable()){ _loadThread.join(); }//wait until _buff_A is filled
+        if(_numChunks == 1){
+            //Small (or empty) file: a single read on this thread. 
+            //Starting and joining the load thread would cost more than the read itself.
+            _buff_a.reset_ix();
+            _buff_a.set_apparent_size(_fileByteSize);
+            if(_fileByteSize > 0){
+                const chunk_event_span ev = _events.begin(chunk_io_event::chunk_load, 0, _fileByteSize);
+                _io.read_at(_buff_a.data_begin(), _fileByteSize, 0);
+                _events.end(ev);
+            }
+            return;
         }
+
+        fetchIntoBuff_thrd(true, 0); // true: fill _buff_A (doesn't block the thread)
+
+        //at the start of the function it waits for the _buff_A to fill. (blocks the thread)
+        //NOTICE: there are at least 2 chunks, the single-chunk case was handled above.
+        fetchIntoBuff_thrd(false, 1);
         //NOTICE: don't invoke 'focus_next_buffer()' yet.
+    }
 
-        _isA = true;
+
+    // Reads from memory instead of a file. Only for 'is_in_memory' backends that take a region,
+    // for example memory_source_backend. The bytes must stay alive until EndRead().
+    template<typename B = Backend,  typename = std::enable_if_t<is_in_memory_backend<B>::value>>
+    void BeginRead(const void* bytes,  size_t numBytes){
+        EndRead();
+        _io.set_source(bytes, numBytes);
+        BeginRead(std::string("<memory>"));
+    }
+
+
+    // Only opens the file, nothing is loaded and there is nothing for sequential reading.
+    // Use read_rawData_at() to get bytes at known offsets (for example, columnar_file.h).
+    void BeginReadAt(const std::string& fileName_with_exten){
+        EndRead();
+        if (_io.open_read(fileName_with_exten) == false){
+            throw std::runtime_error("file_read_chunks() could not open filePath: " + fileName_with_exten);
+        }
+        _path = fileName_with_exten;
+        _fileByteSize = _io.size();
+        _ix_inEntireFile = _fileByteSize;//HasMoreForRead() is false
+        _chunkSize = _lastChunkSize = 0;
+        _numChunks = 1;
         _readingChunk_id = 0;
+        _isA = true;
+        _buff_a.reset_ix();
+        _buff_a.set_apparent_size(0);
+    }
+
+
+    // Continues sequential reading from 'offset' in the file. Loads only the chunk that
+    // contains it (and starts loading the one after). Works after BeginRead() or BeginReadAt().
+    void seek(size_t offset){
+        assert(_io.is_open());
+        if(offset > _fileByteSize){ throw std::runtime_error("seek() beyond the end of the file."); }
+        wait_for_loadThread();
+
+        if constexpr (k_inMemory){
+            _buff_a.set_view(_io.data(), _fileByteSize);
+            _buff_a.skipBytes(offset);
+            _ix_inEntireFile = offset;
+            return;
+        }
+        layout_chunks();
+        const int chunkId =  (int)std::min<size_t>(offset / _chunkSize,  _numChunks - 1);
+        _isA = true;
+        _readingChunk_id = chunkId;
+
+        fetchIntoBuff_thrd(true, chunkId);
+        if(chunkId + 1 < _numChunks){  fetchIntoBuff_thrd(false, chunkId + 1);  }//waits for 'chunkId' first
+        else{  wait_for_loadThread();  }
+
+        _buff_a.skipBytes(offset - (size_t)chunkId * _chunkSize);
+        _ix_inEntireFile = offset;
+    }
+
+
+    // Looks for the index that file_writer_chunks stores when markRecord_key() or markRecord() was used (see chunk_index.h).
+    // Returns false if the file doesn't have one.
+    // If it does, the index itself is no longer part of sequential reading: the file "ends" where the data ends.
+    // For the least loading:  BeginReadAt(),  load_index(),  then seek(), seekToRecord(), for_each_record_inKeyRange() or lookup()
+    bool load_index(){
+        assert(_io.is_open());
+        _index = chunk_index();
+        uint64_t tail[2];//footer offset, magic
+        if(_fileByteSize < sizeof(tail)){ return false; }
+
+        read_rawData_at(_fileByteSize - sizeof(tail), (char*)tail, sizeof(tail));
+        if(tail[1] != chunk_index::k_magic  ||  tail[0] > _fileByteSize - sizeof(tail)){ return false; }
+
+        std::vector<unsigned char> footer(_fileByteSize - tail[0]);
+        read_rawData_at(tail[0], (char*)footer.data(), footer.size());
+        _index.decode_footer(footer.data(), footer.size());
+        _index.dataBytes = tail[0];
+
+        const size_t pos = std::min<size_t>(_ix_inEntireFile, tail[0]);
+        _fileByteSize = tail[0];
+        if(_chunkSize == 0){  _ix_inEntireFile = _fileByteSize;  }//after BeginReadAt(), still nothing to read
+        else{  seek(pos);  }//lay the chunks out again, for the smaller size
+        return true;
+    }
+
+    const chunk_index& index()const{ return _index; }
+
+
+    // Goes to record 'recordIx' (counted from 0), using the record offsets of the index (see markRecord()).
+    // Lands on the closest stored record at or before it, and returns how many records you must
+    // still read (or skip) to reach 'recordIx'. Fewer than the writer's stride.
+    size_t seekToRecord(uint64_t recordIx){
+        if(_index.recordOffsets.empty()){ throw std::runtime_error("the file has no record offsets, see load_index()"); }
+        if(recordIx >= _index.numRecords){
+            throw std::runtime_error("record " + std::to_string(recordIx) + " is beyond the "
+                                     + std::to_string(_index.numRecords) + " records of the file");
+        }
+        const uint64_t stored = recordIx / _index.recordStride;
+        seek(_index.recordOffsets[stored]);
+        return (size_t)(recordIx - stored * _index.recordStride);
+    }
+
+    uint64_t numRecords()const{ return _index.numRecords; }//0 if the index has no record offsets
+
+
+    // Calls fn() for the records of every zone whose keys might be in [lo, hi] (see chunk_index.h).
+    // fn() must read exactly one record, and check its key: zones only rule out what can't match.
+    // Zones that can't match are never loaded.
+    template<typename Fn>
+    void for_each_record_inKeyRange(int64_t lo,  int64_t hi,  Fn&& fn){
+        for_each_record_inZones([&](size_t z){ return _index.zone_mightMatch(z, lo, hi); },  fn);
+    }
+
+    // Point lookup: calls fn() for the records of every zone that might have 'key'.
+    // Uses the Bloom filters if the writer made them (see enable_bloomFilters()), else only min/max.
+    // Same as above, fn() must read exactly one record and compare its key.
+    template<typename Fn>
+    void lookup(int64_t key,  Fn&& fn){
+        for_each_record_inZones([&](size_t z){ return _index.zone_mightContain(z, key); },  fn);
     }
 
 
     void EndRead(){
         if(_loadThread.joinable()){  _loadThread.join();  }
-        if(_file.is_open()){  _file.close(); }
+        if(_io.is_open()){  _io.close(); }
     }
 
 
@@ -98,21 +263,34 @@ public:
     }
 
     
-    size_t fileByteSize() const {  assert(_file.is_open()); return _fileByteSize;  }
+    size_t fileByteSize() const {  assert(_io.is_open()); return _fileByteSize;  }
 
     size_t remainingBytes_total() const { return _fileByteSize - _ix_inEntireFile; } //how many bytes we have left to read
 
+    size_t readPosition() const { return _ix_inEntireFile; } //offset in the file, of the next byte we'll give
+
     size_t remainingBytes_in_currBuff()const{ return get_currBuff().remaining(); }
 
+    // For parsers that work on the loaded bytes directly (for example csv_tokenizer.h).
+    // There are remainingBytes_in_currBuff() of them. Valid until the chunk is used up,
+    // by skip_in_currBuff() or by any read_...()
+    const unsigned char* currBuff_data(){ return get_currBuff().data_current(); }
+
+    // Moves forward inside the current chunk, no further than remainingBytes_in_currBuff().
+    // Reaching its end switches to the next chunk.
+    void skip_in_currBuff(size_t numBytes){
+        assert(numBytes <= get_currBuff().remaining());
+        consume_in_currBuff(numBytes);
+    }
+
 
 
 
     // Loads into buffers, and stores into 'outputHere'.
     // Swaps buffers until all information is retrieved.
     void read_rawData( char* outputHere, size_t numBytes ){
-        assert(_file.is_open());
+        assert(_io.is_open());
         if(numBytes > _fileByteSize-_ix_inEntireFile){ throw std::runtime_error("requesting more byte than there remains to be read."); }
-        const size_t numBytes_copy = numBytes;
 
         while(numBytes > 0){
                 RawData_Buff& buff =  get_currBuff();
@@ -120,28 +298,56 @@ public:
                 const size_t numCopy =  numBytes > bufRemain ?  bufRemain : numBytes;
         
                 std::memcpy(outputHere, buff.data_current(), numCopy);
-                buff.skipBytes(numCopy);
-
-                if(buff.endReached()){
-                    focus_next_buffer();
-                    if(_readingChunk_id < _numChunks-1){   
-                        //check if we are about to load into final chunk
-                        int id_for_load =  _readingChunk_id+1;
-                        bool willLoadIntoFinalChunk =  id_for_load == (_numChunks-1);
-                        // NOTICE:  !_isA  because we start loading into the buffer 
-                        // that we've just been using to read from.
-                        fetchIntoBuff_thrd( !_isA, willLoadIntoFinalChunk);
-                    }else{
-                        // reading final chunk. MAke sure it was fully loaded. 
-                        // ITS IMPORTANT!!! (the fetchIntoBuff_thrd() was synching, but we didn't run it in this 'else')
-                        if (_loadThread.joinable()){ _loadThread.join(); }
-                    }
-                }
+                consume_in_currBuff(numCopy);
+
                 outputHere += numCopy;
                 numBytes -= numCopy;
         }//end while
+    }
+
 
-        _ix_inEntireFile += numBytes_copy;
+    // Same as read_rawData() into each of the 'numPieces', one after another.
+    // If they are all in the current chunk, it's just the memcpys.
+    void read_rawDatav(const iovec* pieces,  size_t numPieces){
+        assert(_io.is_open());
+        size_t total = 0;
+        for(size_t i=0; i<numPieces; ++i){ total += pieces[i].iov_len; }
+        if(total > _fileByteSize-_ix_inEntireFile){ throw std::runtime_error("requesting more byte than there remains to be read."); }
+
+        RawData_Buff& buff =  get_currBuff();
+        //"less than": reaching the end of the chunk must go through read_rawData(), to swap the buffers.
+        if(total < buff.remaining()){
+            const unsigned char* src = buff.data_current();
+            for(size_t i=0; i<numPieces; ++i){
+                std::memcpy(pieces[i].iov_base, src, pieces[i].iov_len);
+                src += pieces[i].iov_len;
+            }
+            buff.skipBytes(total);
+            _ix_inEntireFile += total;
+            return;
+        }
+        for(size_t i=0; i<numPieces; ++i){
+            read_rawData((char*)pieces[i].iov_base, pieces[i].iov_len);
+        }
+    }
+
+
+    // Reads 'numBytes' starting at 'offset' in the file, straight into 'outputHere' (ReadAt).
+    // Doesn't use or disturb the chunks, nor the position of sequential reading.
+    void read_rawData_at(size_t offset,  char* outputHere,  size_t numBytes){
+        assert(_io.is_open());
+        if(offset > _fileByteSize  ||  numBytes > _fileByteSize - offset){
+            throw std::runtime_error("read_rawData_at() is beyond the end of the file.");
+        }
+        if constexpr (k_inMemory){
+            std::memcpy(outputHere, _io.data() + offset, numBytes);
+            return;
+        }
+        const size_t chunkIx =  offset / std::max<size_t>(1, _buff_a.totalAlocatedSize());
+        const chunk_event_span ev = _events.begin(chunk_io_event::chunk_load, chunkIx, numBytes);
+        const size_t got = _io.read_at(outputHere, numBytes, offset);
+        _events.end(ev);
+        if(got != numBytes){ throw std::runtime_error("read_rawData_at() could only read part of the bytes."); }
     }
 
 
@@ -151,18 +357,349 @@ public:
     }
 
     void read_String(std::string& output, size_t numChars){
-        assert(_file.is_open());
+        assert(_io.is_open());
         output.resize(numChars);
         read_rawData( &output[0], numChars);
     }
 
+    // Same as read_String(), but the text is placed into 'arena' instead of a std::string of its own.
+    // Lots of short strings then cost no malloc/free each (see string_arena.h).
+    // The view is valid until the arena is reset.
+    std::string_view read_String(string_arena& arena,  size_t numChars){
+        assert(_io.is_open());
+        char* dst = arena.allocate(numChars);
+        read_rawData(dst, numChars);
+        return std::string_view(dst, numChars);
+    }
+
+    // Same, with the arena of this reader. Call arena().reset() when you no longer need the views.
+    std::string_view read_String_arena(size_t numChars){  return read_String(_arena, numChars);  }
+
+    string_arena& arena(){ return _arena; }
+
+
+    // Same as read_String(), but checks UTF-8 during the copy (so the bytes are only touched once).
+    // Returns false if the text isn't valid UTF-8. The 'output' gets the bytes either way.
+    // 'numBytes' is in bytes, not in characters.
+    bool read_String_utf8(std::string& output,  size_t numBytes){
+        assert(_io.is_open());
+        if(numBytes > _fileByteSize-_ix_inEntireFile){ throw std::runtime_error("requesting more byte than there remains to be read."); }
+        output.resize(numBytes);
+        unsigned char* dst = (unsigned char*)output.data();
+
+        utf8_validator validator;
+        while(numBytes > 0){
+            RawData_Buff& buff =  get_currBuff();
+            const size_t bufRemain =  buff.remaining();
+            const size_t numCopy =  numBytes > bufRemain ?  bufRemain : numBytes;
+
+            validator.copy(dst, buff.data_current(), numCopy);//a character split between chunks is fine
+            consume_in_currBuff(numCopy);
+
+            dst += numCopy;
+            numBytes -= numCopy;
+        }
+        return validator.finish();
+    }
+
+
+    // Reads up to 'maxRecords' packed records of type Rec, straight from the chunks into the
+    // columns (see soa_column.h). Returns how many were read: fewer if the file has fewer.
+    // Only a record split between two chunks is copied into a temporary first.
+    template<typename Rec,  typename... Cols>
+    size_t read_RecordsSoA(size_t maxRecords,  const Cols&... columns){
+        static_assert(std::is_trivially_copyable_v<Rec>,  "records must be plain bytes");
+        static_assert((std::is_same_v<typename Cols::record_type, Rec>  &&  ...),  "every soa_column must be a field of Rec");
+        assert(_io.is_open());
+        const size_t numRecords =  std::min(maxRecords,  remainingBytes_total() / sizeof(Rec));
+
+        size_t done = 0;
+        while(done < numRecords){
+            RawData_Buff& buff =  get_currBuff();
+            const size_t inChunk =  std::min(numRecords - done,  buff.remaining() / sizeof(Rec));
+
+            if(inChunk == 0){
+                //this record is partly in the next chunk
+                Rec tmp;
+                read_rawData((char*)&tmp, sizeof(Rec));
+                (columns.scatter((const unsigned char*)&tmp, 1, done), ...);
+                ++done;
+                continue;
+            }
+            //a few records at a time, for all columns, so they stay in L1 cache:
+            const unsigned char* src = buff.data_current();
+            for(size_t b = 0;  b < inChunk;  b += k_soaBlockRecords){
+                const size_t n = std::min(k_soaBlockRecords,  inChunk - b);
+                (columns.scatter(src + b*sizeof(Rec), n, done + b), ...);
+            }
+            consume_in_currBuff(inChunk * sizeof(Rec));
+            done += inChunk;
+        }
+        return numRecords;
+    }
+
+
+    // Skips spaces, tabs and line breaks. Returns false if the file ended.
+    bool skip_Whitespace(){
+        return skip_while([](char c){ return c==' ' || c=='\t' || c=='\n' || c=='\r'; });
+    }
+
+    // Skips any of the 'chars', for example  skip_Chars(" ,;\t")
+    // Returns false if the file ended.
+    bool skip_Chars(std::string_view chars){
+        return skip_while([chars](char c){ return chars.find(c) != std::string_view::npos; });
+    }
+
+
+    // Parses a decimal integer written as text, for example -42 or +42. Skips whitespace before it.
+    // Like strtol, takes the longest prefix that is a number, and stops right after it:
+    // 12abc gives 12, and 'abc' is left for the next read. A leading + is allowed.
+    // Parses straight from the chunk. Only a number crossing into the next chunk is copied.
+    // Throws std::runtime_error if there is no number, or it doesn't fit into T.
+    template<typename T>
+    void read_AsciiInt(T& output){
+        static_assert(std::is_integral_v<T>, "read_AsciiInt() needs an integer");
+        read_AsciiNumber(output);
+    }
+
+    // Same as read_AsciiInt(), for  3.25  -1e-7  .5  inf  infinity  nan  etc. (no hex).
+    // Like strtod,  3.5px  gives 3.5 and  2e  gives 2, leaving 'px' and 'e' unread.
+    // NOTICE: one exception, when a chunk boundary cuts such an unfinished part ( 2e|x  infin|x ):
+    // it was already consumed by then, so this throws instead.
+    void read_AsciiDouble(double& output){
+        read_AsciiNumber(output);
+    }
+
 
 private:
-    void fetchIntoBuff_thrd(bool isLoad_intoA, bool isLoadIntoFinalChunk){
-        if (_loadThread.joinable()){ _loadThread.join(); }
+    template<typename Pred,  typename Fn>
+    void for_each_record_inZones(Pred&& zoneMatches,  Fn& fn){
+        if(!_index.hasZones()){ throw std::runtime_error("the file has no zone maps, see load_index()"); }
+        for(size_t z=0; z<_index.zones.size(); ++z){
+            if(!zoneMatches(z)){ continue; }
+            //NOTICE: consecutive zones continue where the previous one stopped, without a seek.
+            if(_ix_inEntireFile != _index.zones[z].firstRecordOffset){  seek(_index.zones[z].firstRecordOffset);  }
+            const uint64_t end = _index.zone_end(z);
+            while(_ix_inEntireFile < end){ fn(); }
+        }
+    }
+
+
+    template<typename T>
+    void read_AsciiNumber(T& output){
+        assert(_io.is_open());
+        if(!skip_Whitespace()){ throw std::runtime_error("expected a number, but the file ended."); }
+        number_scan scan{ std::is_floating_point_v<T> };
+
+        RawData_Buff& buff =  get_currBuff();
+        const char* first =  (const char*)buff.data_current();
+        const size_t n =     buff.remaining();
+        size_t k = 0;
+        while(k < n  &&  scan.take(first[k])){ ++k; }
+
+        //NOTICE: if the scan reached the end of the chunk, the number might continue in the next one.
+        if(k < n  ||  n == remainingBytes_total()){
+            parse_number(first, scan, output);
+            consume_in_currBuff(scan.numValid);
+            return;
+        }
+
+        //Slow path: the number crosses into the next chunk. Gather it.
+        _carry.assign(first, n);
+        consume_in_currBuff(n);
+        while(HasMoreForRead()){
+            RawData_Buff& b =  get_currBuff();
+            const char* p =  (const char*)b.data_current();
+            const size_t m =  b.remaining();
+            size_t j = 0;
+            while(j < m  &&  scan.take(p[j])){ ++j; }
+            if(j < m  ||  m == 0){
+                //it ends in this chunk: leave whatever follows its valid part
+                const size_t more =  scan.numValid > _carry.size() ? scan.numValid - _carry.size() : 0;
+                _carry.append(p, more);
+                consume_in_currBuff(more);
+                break;
+            }
+            _carry.append(p, m);
+            consume_in_currBuff(m);
+        }
+        if(scan.numValid != _carry.size()){ throw std::runtime_error("malformed number in text: " + _carry); }
+        parse_number(_carry.data(), scan, output);
+    }
+
+
+    // Finds the longest prefix that is a number, one char at a time:
+    //   [+-] digits [.digits] [e [+-] digits]     or  [+-] .digits...     or  [+-] inf / infinity / nan
+    // Integers only get the sign and the digits.
+    struct number_scan {
+        enum state : uint8_t {  k_start,  k_sign,  k_whole,  k_dot,  k_frac,  k_exp,  k_expSign,  k_expDigits,  k_word,  k_done  };
+
+        bool isFloat;
+        state st = k_start;
+        bool plus = false;//from_chars doesn't take a leading +, it's skipped when parsing
+        size_t numTaken = 0;
+        size_t numValid = 0;//the longest prefix of the taken chars, that is a complete number
+        const char* word = nullptr;//"infinity" or "nan"
+        size_t wordLen = 0;
+
+        // Returns false if 'c' can't continue the number (then the scan is over).
+        bool take(char c){
+            const bool digit =  c >= '0'  &&  c <= '9';
+            const char lower =  (char)(c | 0x20);
+            switch(st){
+                case k_start:
+                    if(c == '+'){  plus = true;  return next(k_sign, false);  }
+                    if(c == '-'){  return next(k_sign, false);  }
+                    [[fallthrough]];
+                case k_sign:
+                    if(digit){ return next(k_whole, true); }
+                    if(isFloat  &&  c == '.'){ return next(k_dot, false); }
+                    if(isFloat  &&  (lower == 'i'  ||  lower == 'n')){
+                        word =  lower == 'i' ? "infinity" : "nan";
+                        wordLen = 1;
+                        return next(k_word, false);
+                    }
+                    break;
+                case k_whole:
+                    if(digit){ return next(k_whole, true); }
+                    if(isFloat  &&  c == '.'){ return next(k_frac, true); }
+                    if(isFloat  &&  lower == 'e'){ return next(k_exp, false); }
+                    break;
+                case k_dot:
+                    if(digit){ return next(k_frac, true); }
+                    break;
+                case k_frac:
+                    if(digit){ return next(k_frac, true); }
+                    if(lower == 'e'){ return next(k_exp, false); }
+                    break;
+                case k_exp:
+                    if(c == '+'  ||  c == '-'){ return next(k_expSign, false); }
+                    [[fallthrough]];
+                case k_expSign:
+                case k_expDigits:
+                    if(digit){ return next(k_expDigits, true); }
+                    break;
+                case k_word:
+                    if(word[wordLen] != '\0'  &&  lower == word[wordLen]){
+                        ++wordLen;
+                        return next(k_word,  wordLen == 3  ||  wordLen == 8);//inf, nan, infinity
+                    }
+                    break;
+                case k_done: break;
+            }
+            st = k_done;
+            return false;
+        }
+
+        bool next(state s,  bool valid){
+            st = s;
+            ++numTaken;
+            if(valid){ numValid = numTaken; }
+            return true;
+        }
+    };
+
+    // 'text' starts with the chars given to 'scan'.
+    template<typename T>
+    static void parse_number(const char* text,  const number_scan& scan,  T& output){
+        const std::string_view token(text, scan.numValid);
+        if(scan.numValid == 0){
+            throw std::runtime_error("expected a number in text, got: " + std::string(text, std::max<size_t>(scan.numTaken, 1)));
+        }
+        const char* first =  text + (scan.plus ? 1 : 0);
+        const char* last =   text + scan.numValid;
+        const std::from_chars_result r = std::from_chars(first, last, output);
+        if(r.ec == std::errc::result_out_of_range){ throw std::runtime_error("number in text is out of range: " + std::string(token)); }
+        if(r.ec != std::errc()  ||  r.ptr != last){ throw std::runtime_error("malformed number in text: " + std::string(token)); }
+    }
+
+
+    template<typename Pred>
+    bool skip_while(Pred&& pred){
+        assert(_io.is_open());
+        while(HasMoreForRead()){
+            RawData_Buff& buff =  get_currBuff();
+            const char* p =  (const char*)buff.data_current();
+            const size_t n =  buff.remaining();
+            size_t k = 0;
+            while(k < n  &&  pred(p[k])){ ++k; }
+            consume_in_currBuff(k);
+            if(k < n  ||  n == 0){ return k < n; }
+        }
+        return false;
+    }
+
+
+    // Picks the chunk size for the file (if it's automatic), and how the file is cut into chunks.
+    void layout_chunks(){
+        if constexpr (k_inMemory){
+            _chunkSize = _lastChunkSize = _fileByteSize;
+            _numChunks = 1;
+            return;
+        }
+        if(_fileByteSize == 0){
+            //NOTICE: nothing to load, but keep '_chunkSize' above 0 even in auto mode (nothing allocated yet):
+            //offsets are divided by it, see seek().
+            _chunkSize =     std::max<size_t>(_buff_a.totalAlocatedSize(), 1);
+            _numChunks =     1;
+            _lastChunkSize = 0;
+            return;
+        }
+        //NOTICE: a file that fits into the buffers we already have, doesn't need a probe.
+        //Saves a statx() per file, when reading lots of small files.
+        if(_isAutoChunkSize  &&  _fileByteSize > _buff_a.totalAlocatedSize()){
+            const device_info dev = device_info::probe(_path);
+            if(_buff_a.totalAlocatedSize() != dev.chunkBytes  ||  _buff_a.alignment() != dev.alignment){
+                _buff_a.reallocate(dev.chunkBytes, dev.alignment);
+                _buff_b.reallocate(dev.chunkBytes, dev.alignment);
+            }
+        }
 
+        _chunkSize =     _buff_a.totalAlocatedSize();
+        _numChunks =     (int)(_fileByteSize / _chunkSize);
+        _lastChunkSize = _fileByteSize % _chunkSize; //in case there are some left overs 
+        // 'numChunks' includes the last chunk.
+        // If there was no remainder, then the last chunk is normal.
+        // Make sure to set it, because it will be used on last iter:
+        if(_lastChunkSize > 0){ _numChunks++; }
+        else{ _lastChunkSize = _chunkSize; }
+
+        if(_fileByteSize <= _chunkSize){
+            _numChunks = 1;
+            _lastChunkSize = _fileByteSize;
+        }
+    }
+
+
+    // Moves 'numBytes' forward in the current chunk (no further than its end).
+    // When the chunk is used up, switches to the other buffer, and starts loading the next chunk.
+    void consume_in_currBuff(size_t numBytes){
+        RawData_Buff& buff =  get_currBuff();
+        buff.skipBytes(numBytes);
+        _ix_inEntireFile += numBytes;
+        if(!buff.endReached()){ return; }
+
+        focus_next_buffer();
+        if(_readingChunk_id < _numChunks-1){   
+            // NOTICE:  !_isA  because we start loading into the buffer 
+            // that we've just been using to read from.
+            fetchIntoBuff_thrd( !_isA, _readingChunk_id+1);
+        }else{
+            // reading final chunk. MAke sure it was fully loaded. 
+            // ITS IMPORTANT!!! (the fetchIntoBuff_thrd() was synching, but we didn't run it in this 'else')
+            wait_for_loadThread();
+        }
+    }
+
+
+    // Starts loading chunk 'chunkId' of the file, on a separate thread.
+    void fetchIntoBuff_thrd(bool isLoad_intoA, int chunkId){
+        wait_for_loadThread();
+
+        const bool isLoadIntoFinalChunk =  chunkId == (_numChunks-1);
         size_t this_chunk_size =  isLoadIntoFinalChunk ? _lastChunkSize /* then fill chunk with remaining bytes */
                                                        : _chunkSize; /* else fill entire chunk */
+        const size_t offset =  (size_t)chunkId * _chunkSize;
 
         // NOTICE:  we don't use '_isA' because it might get changed while this thread works
         // (could be launched on a separate thread.)
@@ -179,14 +716,25 @@ private:
         //otherwise, when the scope ends, the value inside lambda will point to garbage.
         //so, both arguments are by value, but 'this' allows us to access the member vars by reference
         //https://stackoverflow.com/a/21106201/9007125.
-        auto lambda =  [this_chunk_size, buf_ptr, this]{
-            this->_file.read((char*)buf_ptr->data_begin(), this_chunk_size);
+        auto lambda =  [this_chunk_size, offset, buf_ptr, chunkId, this]{
+            const chunk_event_span ev = this->_events.begin(chunk_io_event::chunk_load, chunkId, this_chunk_size);
+            this->_io.read_at(buf_ptr->data_begin(), this_chunk_size, offset);
+            this->_events.end(ev);
         };
 
         _loadThread = std::thread( lambda );
     }
 
 
+    // Invoked from the user's thread, when it needs the chunk that's (maybe) still loading.
+    void wait_for_loadThread(){
+        if (!_loadThread.joinable()){ return; }
+        const chunk_event_span ev = _events.begin(chunk_io_event::consumer_wait, _readingChunk_id);
+        _loadThread.join();
+        _events.end(ev);
+    }
+
+
 private:
     const RawData_Buff& get_currBuff()const{  return _isA ? _buff_a : _buff_b;  }
           RawData_Buff& get_currBuff(){  return _isA ? _buff_a : _buff_b;  }
@@ -199,8 +747,12 @@ private:
 
 
 private:
-    std::ifstream _file;
-    size_t _fileByteSize = 0;
+    static constexpr bool k_inMemory = is_in_memory_backend<Backend>::value;
+    static constexpr size_t k_soaBlockRecords = 256;//records per block, in read_RecordsSoA()
+
+    Backend _io;
+    std::string _path;
+    size_t _fileByteSize = 0;//NOTICE: where the data ends, if the file has an index (see load_index())
     size_t _ix_inEntireFile = 0;
     int _numChunks = 0;
     size_t _chunkSize = 0;
@@ -211,6 +763,16 @@ private:
     bool _isA = true;
     RawData_Buff _buff_a;
     RawData_Buff _buff_b;
+    const bool _isAutoChunkSize;//chunk size was 0 in constructor
 
     std::thread _loadThread;
+
+    std::string _carry;//a number that crosses from one chunk into the next
+    string_arena _arena;//for read_String_arena()
+    chunk_index _index;//see load_index()
+
+    chunk_event_sink<Hooks> _events;
 };
+
+
+using file_read_chunks = basic_file_read_chunks<default_io_backend>;
@@ -7,7 +7,18 @@
 #include <fstream>
 #include <filesystem>
 #include <future>
+#include <algorithm>
 #include <cassert>
+#include <type_traits>
+#include <charconv>
+#include <string_view>
+#include <vector>
+#include "io_backends.h"
+#include "chunk_hooks.h"
+#include "chunk_profile.h"
+#include "device_info.h"
+#include "RawData_Buff.h"
+#include "chunk_index.h"
 
 // Add your bytes to the current buffer (there are two internally).
 // When one buffer gets full it will be written to the file asynchronously, 
@@ -20,25 +31,52 @@
 //  fileSize_curr()
 //  numBytesStored_soFar()
 //  writeBytes()
+//  writeBytesv()
+//  write_Literal()
+//  write_Int()  write_Double()  write_Format()    <-- text, rendered straight into the buffer
+//  batch()           <-- many small writes under one lock
+//  markRecord_key()  <-- optional index of records, for file_read_chunks::load_index()
+//  enable_bloomFilters()  <-- and per-chunk Bloom filters of their keys, for file_read_chunks::lookup()
+//  markRecord()      <-- optional offsets of records, for file_read_chunks::seekToRecord()
 //  overwriteBytes_slow()
 //
-class file_writer_chunks {
+// 'Hooks' lets you observe the internal events at compile time, see chunk_hooks.h
+// 'Backend' is where the bytes go, see io_backends.h
+// Use 'file_writer_chunks' for the default one.
+// If the backend is 'is_in_memory', bytes are given to it directly: no buffers, no async writes.
+//
+template<typename Backend,  typename Hooks = no_chunk_hooks>
+class basic_file_writer_chunks {
 public:
     // Choose the size that is likely to saturate HDD bandwidth.
     // Too little or too large will make you wait more than necessary, for HDD to complete.
-    file_writer_chunks(){}
+    basic_file_writer_chunks(){}
 
 
-    ~file_writer_chunks(){
-        if(_buff_A != nullptr){ delete[] _buff_A; }
-        if(_buff_B != nullptr){ delete[] _buff_B; }
-        _buff_A = _buff_B = nullptr;
+    ~basic_file_writer_chunks(){
+        //buffers might still be getting written, don't free them from underneath the tasks:
+        if(_writeTask_A.valid()){  _writeTask_A.wait();  }
+        if(_writeTask_B.valid()){  _writeTask_B.wait();  }
+        free_buffers();
     }
 
 
+    // For example, to configure it before beginWrite()
+    Backend& backend(){ return _io; }
+
+    // Optional. Records buffer flushes and the waits for them (see chunk_io_trace.h).
+    // nullptr to stop recording. Don't change it during writing.
+    void set_tracer(chunk_io_tracer* tracer){ 
+        std::lock_guard lck(_mu);
+        _events.set_tracer(tracer); 
+    }
+
+    Hooks& hooks(){ return _events.hooks(); }
+
+
     std::string filepath()const {
         std::lock_guard lck(_mu);
-        if(_f.is_open()==false){ return ""; }
+        if(_io.is_open()==false){ return ""; }
         return _path_file_with_exten;  
     }
 
@@ -47,8 +85,8 @@ public:
     // entire size of the file, including the reserved space:
     ssize_t fileSize_curr()const{
         std::lock_guard lck(_mu);
-        if(_f.is_open()==false){ return -1; }
-        return std::filesystem::file_size( _path_file_with_exten );
+        if(_io.is_open()==false){ return -1; }
+        return _io.size();
     }
     
 
@@ -61,37 +99,60 @@ public:
 
     bool isOpen()const{ 
         std::lock_guard lck(_mu); 
-        return _f.is_open(); 
+        return _io.is_open(); 
     }
 
 
 
+    // bufferSizeBytes:  by default, the size that suits this machine (see chunk_profile.h)
+    //                   0 picks it for the device the file is on (see device_info.h)
+    // openMode:  std::ios::trunc  wipes the file.
+    //            std::ios::app    keeps the contents, and we continue after the last existing byte.
+    //            std::ios::in     keeps the contents, but we start writing from byte zero.
     void beginWrite( const std::string& path_file_with_exten,  
                      size_t startingFilesizeBytes = 1024,  
                      std::ios_base::openmode openMode = std::ios::trunc,
-                     size_t bufferSizeBytes=1024*1024 ){
+                     size_t bufferSizeBytes = chunk_profile::get_default().write_bufferBytes ){
 
-        assert(bufferSizeBytes >= 1024);//else, not performant
+        size_t alignment = 16;
+        if(bufferSizeBytes == 0  &&  !k_inMemory){
+            const device_info dev = device_info::probe(path_file_with_exten);
+            bufferSizeBytes = dev.chunkBytes;
+            alignment = dev.alignment;
+        }
+        assert(k_inMemory  ||  bufferSizeBytes >= 1024);//else, not performant
         std::lock_guard lck(_mu);
-        std::lock_guard lckFile(_mu_fileAccess);
+
+            //the previous file might not have been completed: its buffers can still be getting written.
+            //Don't free them or close the file from underneath the tasks. (Their errors belong to that file, drop them)
+            if(_writeTask_A.valid()){  _writeTask_A.wait();  _writeTask_A = std::future<void>();  }
+            if(_writeTask_B.valid()){  _writeTask_B.wait();  _writeTask_B = std::future<void>();  }
 
             _path_file_with_exten =  path_file_with_exten;
-            _buffSizeBytes = bufferSizeBytes;
-            _buff_A = new unsigned char[bufferSizeBytes];
-            _buff_B = new unsigned char[bufferSizeBytes];
-
-            if(_f.is_open()){ _f.close(); }
-            if(std::filesystem::exists(path_file_with_exten)){
-                _f.open(path_file_with_exten,  openMode | std::ios::binary);
-            }else{
-                _f.open(path_file_with_exten,  std::ios::binary );
+            if constexpr (!k_inMemory){
+                //keep the previous buffers if they are the same, saves an allocation per file.
+                if(_buff_A == nullptr  ||  _buffSizeBytes != bufferSizeBytes  ||  _buffAlignment != alignment){
+                    free_buffers();
+                    _buff_A = (unsigned char*)RawData_Buff::alloc_aligned(bufferSizeBytes, alignment);
+                    _buff_B = (unsigned char*)RawData_Buff::alloc_aligned(bufferSizeBytes, alignment);
+                    _buffAlignment = alignment;
+                }
             }
-            if(!_f){  
+            _buffSizeBytes = bufferSizeBytes;
+
+            const bool keepContents =  (openMode & std::ios::trunc) == 0  
+                                       &&  (openMode & (std::ios::app | std::ios::in)) != 0;
+            if(_io.is_open()){ _io.close(); }
+            if(!_io.open_write(path_file_with_exten, !keepContents)){  
                 throw(std::runtime_error("file" + path_file_with_exten + "couldn't open")); 
             }
 
+            const size_t existingBytes =  keepContents ? _io.size() : 0;
+            _appendOffset =  (openMode & std::ios::app) ? existingBytes : 0;
+
             try {
-                std::filesystem::resize_file( path_file_with_exten, startingFilesizeBytes);
+                //NOTICE: never shrink below what we are keeping.
+                _io.resize( std::max(startingFilesizeBytes, existingBytes) );
             }catch(std::runtime_error err){
                 auto myError = std::runtime_error("couldn't resize file " + path_file_with_exten 
                                             + " maybe check if there is enough disk space.");
@@ -100,6 +161,13 @@ public:
             }
             _isA = true;
             _next_ix_inBuff = 0;
+            _index = chunk_index();
+            _index.recordStride = _recordStride;
+            _bloomBitsPerKey = _bloomBitsPerKey_next;//NOTICE: fixed for the whole file, so every zone has a filter, with the same number of hashes
+            _bloomKeys.clear();
+            {   std::lock_guard bloomLck(_bloomMu);
+                _blooms.clear();
+            }
             _began = true;
     }
 
@@ -111,10 +179,10 @@ public:
         std::lock_guard lck(_mu);
         assert(_began);
         ensure_all_buffs_flushed_to_file();
-            std::lock_guard lckFile(_mu_fileAccess);
-                _f.close();//finish
-                _path_file_with_exten = "";
-                _began = false;
+            if(!_index.empty()){  write_index_footer();  }
+            _io.close();//finish
+            _path_file_with_exten = "";
+            _began = false;
     }
 
 
@@ -127,6 +195,133 @@ public:
     }
 
 
+    // Same as writeBytes() for each of the 'numPieces', one after another.
+    // But locks only once, and if they all fit in the current buffer, it's just the memcpys.
+    // For example, header + key + value of a record.
+    void writeBytesv(const iovec* pieces,  size_t numPieces){
+        std::lock_guard lck(_mu);
+            writeBytesv_internal( pieces, numPieces );
+    }
+
+
+    // int, float, struct (shallow, no deep copies), etc.
+    template<typename T>
+    void write_Literal(const T& value){
+        static_assert(std::is_trivially_copyable_v<T>, "only plain bytes can be written");
+        std::lock_guard lck(_mu);
+            writeBytes_internal( &value, sizeof(T) );
+    }
+
+
+    // Decimal text, for example 12345 or -7. No temporary strings: std::to_chars writes 
+    // straight into the current buffer (or into a few stack bytes, at the end of a buffer).
+    template<typename T>
+    void write_Int(T value){
+        std::lock_guard lck(_mu);
+            write_Int_internal( value );
+    }
+
+    // Shortest text that reads back to the exact same value, for example 0.1 or 1e+300.
+    // Or with the given format and precision, for example  write_Double(x, std::chars_format::fixed, 3)
+    void write_Double(double value){
+        std::lock_guard lck(_mu);
+            write_Double_internal( value );
+    }
+    void write_Double(double value,  std::chars_format fmt,  int precision){
+        std::lock_guard lck(_mu);
+            write_Double_internal( value, fmt, precision );
+    }
+
+    // Replaces every {} in 'fmt' with the next argument:  integers, floats, bool,
+    // char, and anything convertible to std::string_view.
+    //    write_Format("{},{},{}\n", id, name, price);
+    // Throws std::runtime_error if the number of {} and arguments differ (before writing anything).
+    template<typename... Args>
+    void write_Format(std::string_view fmt,  const Args&... args){
+        std::lock_guard lck(_mu);
+            write_Format_internal( fmt, args... );
+    }
+
+
+    // Keeps the writer locked while it's alive. Its writes don't lock again, so a burst
+    // of small writes costs one lock instead of one per write:
+    //
+    //    {
+    //        auto b = writer.batch();
+    //        b.write_Literal(header);
+    //        b.writeBytes(key, keyLen);
+    //    }//unlocked here
+    //
+    // NOTICE: don't call the writer's own functions while a batch is alive, that would deadlock.
+    class write_batch {
+    public:
+        void writeBytes(const void* bytes,  size_t count){  _w->writeBytes_internal(bytes, count);  }
+        void writeBytesv(const iovec* pieces,  size_t numPieces){  _w->writeBytesv_internal(pieces, numPieces);  }
+
+        template<typename T>
+        void write_Literal(const T& value){
+            static_assert(std::is_trivially_copyable_v<T>, "only plain bytes can be written");
+            _w->writeBytes_internal(&value, sizeof(T));
+        }
+
+        template<typename T>
+        void write_Int(T value){  _w->write_Int_internal(value);  }
+        void write_Double(double value){  _w->write_Double_internal(value);  }
+        void write_Double(double value,  std::chars_format fmt,  int precision){  _w->write_Double_internal(value, fmt, precision);  }
+
+        template<typename... Args>
+        void write_Format(std::string_view fmt,  const Args&... args){  _w->write_Format_internal(fmt, args...);  }
+
+        void markRecord_key(int64_t key){  _w->markRecord_key_internal(key);  }
+        void markRecord(){  _w->markRecord_internal();  }
+
+    private:
+        friend class basic_file_writer_chunks;
+        explicit write_batch(basic_file_writer_chunks* w) : _lck(w->_mu),  _w(w) {}
+
+        std::unique_lock<std::mutex> _lck;
+        basic_file_writer_chunks* _w;
+    };
+
+    write_batch batch(){ return write_batch(this); }
+
+
+    // Optional. Call it right before writing each record, with the record's key.
+    // completeWrite() then stores the min and max key of the records in each chunk of the file
+    // (zone maps, see chunk_index.h), so readers can skip chunks that can't have the keys they want.
+    // The file is truncated right after this index, the reserved space beyond it is released.
+    void markRecord_key(int64_t key){
+        std::lock_guard lck(_mu);
+            markRecord_key_internal( key );
+    }
+
+    // Optional, on top of markRecord_key(). Also stores a Bloom filter of the keys of each chunk,
+    // so file_read_chunks::lookup() of a single key skips nearly every chunk that doesn't have it,
+    // even when the keys aren't sorted. About 1% false positives with 10 bits per key.
+    // Filters are built on the flush tasks, as each chunk is saved. 0 turns them off.
+    // Applies from the next beginWrite(), and stays on for the files after it.
+    void enable_bloomFilters(size_t bitsPerKey = 10){
+        std::lock_guard lck(_mu);
+            _bloomBitsPerKey_next = bitsPerKey;
+    }
+
+
+    // Optional. Call it right before writing each record (markRecord_key() counts too).
+    // completeWrite() then stores where every Nth record starts, so file_read_chunks::seekToRecord()
+    // can jump near record 'i' and load only the chunk it is in.
+    void markRecord(){
+        std::lock_guard lck(_mu);
+            markRecord_internal();
+    }
+
+    // How often markRecord() stores an offset: every 'everyNth' record. Smaller means less to skip
+    // after seekToRecord(), but a bigger index. Applies from the next beginWrite().
+    void set_recordStride(size_t everyNth){
+        std::lock_guard lck(_mu);
+            _recordStride = everyNth > 0 ? everyNth : 1;
+    }
+
+
     // Very slow. If our buffers are currently being flushed, waits until they finished being flushed.
     // Then, blocks execution until complete and overwrites somewhere in the middle of the file
     void overwriteBytes_slow(size_t numBytesOffset_inFile,  const void* bytes,  size_t count){
@@ -135,27 +330,22 @@ public:
         
         ensure_all_buffs_flushed_to_file();
 
-            std::lock_guard lckFile(_mu_fileAccess);
-
-                size_t p = _f.tellp();
+                size_t p = _appendOffset;
                 bool fileEmpty_afterFlushAll =  p==0; //checks if the position remained at 0 even after flush-attempts of both buffers.
 
                 //you can only overwrite inside the file, or append to the end. Can't start far beyond:
                 nn_dev_assert(numBytesOffset_inFile <= p);
 
-                //NOTICE: we will overwrite any consecutive bytes in a file, NOT insert. http://www.cplusplus.com/forum/beginner/150097/
-                _f.seekp(numBytesOffset_inFile, std::ios_base::beg);
-                _f.write((const char*)bytes, count);
+                //NOTICE: we will overwrite any consecutive bytes in a file, NOT insert. 
+                _io.write_at(bytes, count, numBytesOffset_inFile);
 
                 //NOTICE: both buffers were already flushed above. 
 
                 if(fileEmpty_afterFlushAll){
-                    /*Do nothing. 
-                      That's because we wrote into the file for the first time, flush_all_nonsaved_toFile() didn't store anything.
-                      So, keep the pointer where it ended up, DON'T revert it back (to zero).
+                    /*That's because we wrote into the file for the first time, flush_all_nonsaved_toFile() didn't store anything.
+                      So, continue from where these bytes ended, DON'T stay at zero.
                       Otherwise, some future buffer would dump itself into file at zero, overwriting our stuff*/
-                }else{
-                    _f.seekp(p, std::ios_base::beg);//come back to original place.
+                    _appendOffset = numBytesOffset_inFile + count;
                 }
     }
 
@@ -164,14 +354,17 @@ private:
     void ensure_all_buffs_flushed_to_file(){
         //NOTICE: mutex is already locked.
 
-        if(_writeTask_A.valid()){  _writeTask_A.get();  }
-        if(_writeTask_B.valid()){  _writeTask_B.get();  }
+        wait_for_writeTask(_writeTask_A);
+        wait_for_writeTask(_writeTask_B);
 
         const size_t count =  _next_ix_inBuff;
 
         if(count > 0){//if some amount remains in one of the buffers:
-            if(_isA){  std::lock_guard lckFile(_mu_fileAccess); _f.write((const char*)_buff_A, count); } //_isA means we were gathering into A. Flush it now.
-            else{      std::lock_guard lckFile(_mu_fileAccess); _f.write((const char*)_buff_B, count); }
+            const chunk_event_span ev = _events.begin(chunk_io_event::flush, _appendOffset/_buffSizeBytes, count);
+            if(_isA){  _io.write_at(_buff_A, count, _appendOffset); } //_isA means we were gathering into A. Flush it now.
+            else{      _io.write_at(_buff_B, count, _appendOffset); }
+            _events.end(ev);
+            _appendOffset += count;
         }
         _next_ix_inBuff = 0;
         _isA = true;
@@ -185,12 +378,18 @@ private:
 
         _numBytesStored += count;  //ASSINGINING BEFORE the while(),  because count will bb decremented soon.
 
+        if constexpr (k_inMemory){
+            _io.write_at(bytes, count, _appendOffset);
+            _appendOffset += count;
+            return;
+        }
+
         while(count > 0){
                 if(_isA){
                     //we wish to store into buffer A, so making sure it's no longer being written to file:
-                    if(_writeTask_A.valid()){  _writeTask_A.get(); }
+                    wait_for_writeTask(_writeTask_A);
                 }else{//we wish to store into B:
-                    if(_writeTask_B.valid()){  _writeTask_B.get(); }
+                    wait_for_writeTask(_writeTask_B);
                 }
 
                 unsigned char* buff =  _isA ? _buff_A : _buff_B;//where we will store.
@@ -203,10 +402,18 @@ private:
                 if(numToWrite < numAvailabile){ break; }//"less than", NOT "less or equal".
 
                 //flush the buffer into file.  Notice, that we use [=] not [&]
-                auto writingLambda = [=]{ 
-                    std::lock_guard lckFile(this->_mu_fileAccess);
-                    this->_f.write( (const char*)buff, _buffSizeBytes);
+                //Each buffer knows its own offset, so A and B can be saved in any order.
+                const size_t offset = _appendOffset;
+                const size_t numBytes = _buffSizeBytes;
+                //Bloom filters of the zones that are now complete are built here too, off the user's thread:
+                const size_t bitsPerKey = _bloomBitsPerKey;
+                auto writingLambda = [=, keys = take_finished_bloomKeys(offset + numBytes)]{ 
+                    const chunk_event_span ev = this->_events.begin(chunk_io_event::flush, offset/numBytes, numBytes);
+                    this->_io.write_at( buff, numBytes, offset);
+                    this->_events.end(ev);
+                    this->build_blooms(keys, bitsPerKey);
                 };
+                _appendOffset += numBytes;
 
                 if(_isA){ _writeTask_A =  std::async(std::launch::async, writingLambda); }
                 else {    _writeTask_B =  std::async(std::launch::async, writingLambda); }
@@ -219,13 +426,224 @@ private:
     }
 
 
+    void writeBytesv_internal(const iovec* pieces,  size_t numPieces){
+        //NOTICE: mutex is already locked.
+        assert(_began);
+
+        size_t total = 0;
+        for(size_t i=0; i<numPieces; ++i){ total += pieces[i].iov_len; }
+
+        if constexpr (!k_inMemory){
+            //"less than", NOT "less or equal": a full buffer must go through writeBytes_internal() to get flushed.
+            if(_next_ix_inBuff + total < _buffSizeBytes){
+                wait_for_writeTask(_isA ? _writeTask_A : _writeTask_B);
+                unsigned char* dst =  (_isA ? _buff_A : _buff_B) + _next_ix_inBuff;
+                for(size_t i=0; i<numPieces; ++i){
+                    std::memcpy(dst, pieces[i].iov_base, pieces[i].iov_len);
+                    dst += pieces[i].iov_len;
+                }
+                _next_ix_inBuff += total;
+                _numBytesStored += total;
+                return;
+            }
+        }
+        for(size_t i=0; i<numPieces; ++i){
+            writeBytes_internal(pieces[i].iov_base, pieces[i].iov_len);
+        }
+    }
+
+
+    template<typename T>
+    void write_Int_internal(T value){
+        //NOTICE: mutex is already locked.
+        static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "write_Int() needs an integer");
+        write_chars_internal([value](char* first, char* last){ return std::to_chars(first, last, value); });
+    }
+
+    void write_Double_internal(double value){
+        //NOTICE: mutex is already locked.
+        write_chars_internal([value](char* first, char* last){ return std::to_chars(first, last, value); });
+    }
+
+    void write_Double_internal(double value,  std::chars_format fmt,  int precision){
+        //NOTICE: mutex is already locked.
+        write_chars_internal([=](char* first, char* last){ return std::to_chars(first, last, value, fmt, precision); });
+    }
+
+
+    // 'render' is  to_chars_result(char* first, char* last)
+    template<typename Render>
+    void write_chars_internal(Render&& render){
+        //NOTICE: mutex is already locked.
+        assert(_began);
+        if constexpr (!k_inMemory){
+            wait_for_writeTask(_isA ? _writeTask_A : _writeTask_B);
+            const size_t numAvailable = _buffSizeBytes - _next_ix_inBuff;
+            //NOTICE: -1, the buffer must not become full here. Only writeBytes_internal() flushes full buffers.
+            if(numAvailable > 1){
+                char* dst =  (char*)(_isA ? _buff_A : _buff_B) + _next_ix_inBuff;
+                const std::to_chars_result r = render(dst, dst + numAvailable - 1);
+                if(r.ec == std::errc()){
+                    _next_ix_inBuff += r.ptr - dst;
+                    _numBytesStored += r.ptr - dst;
+                    return;
+                }
+            }
+        }
+        //near the end of the buffer: render on the stack, and let writeBytes_internal() split it.
+        char tmp[128];
+        std::to_chars_result r = render(tmp, tmp + sizeof(tmp));
+        if(r.ec == std::errc()){
+            writeBytes_internal(tmp, r.ptr - tmp);
+            return;
+        }
+        //huge fixed-notation doubles, or a large precision:
+        std::vector<char> big(sizeof(tmp));
+        do{
+            big.resize(big.size() * 4);
+            r = render(big.data(), big.data() + big.size());
+        }while(r.ec == std::errc::value_too_large);
+        writeBytes_internal(big.data(), r.ptr - big.data());
+    }
+
+
+    template<typename... Args>
+    void write_Format_internal(std::string_view fmt,  const Args&... args){
+        //NOTICE: mutex is already locked.
+        size_t numSlots = 0;
+        for(size_t at = fmt.find("{}");  at != std::string_view::npos;  at = fmt.find("{}", at+2)){ ++numSlots; }
+        if(numSlots != sizeof...(Args)){
+            throw std::runtime_error("write_Format() has " + std::to_string(numSlots) + " {} but "
+                                     + std::to_string(sizeof...(Args)) + " arguments");
+        }
+        (write_Format_piece(fmt, args), ...);
+        writeBytes_internal(fmt.data(), fmt.size());//the text after the last {}
+    }
+
+    // Writes the text before the next {}, then the argument.
+    template<typename T>
+    void write_Format_piece(std::string_view& fmt,  const T& arg){
+        const size_t at = fmt.find("{}");
+        writeBytes_internal(fmt.data(), at);
+        fmt.remove_prefix(at + 2);
+
+        if constexpr (std::is_same_v<T, bool>){
+            const std::string_view text = arg ? "true" : "false";
+            writeBytes_internal(text.data(), text.size());
+        }else if constexpr (std::is_same_v<T, char>){
+            writeBytes_internal(&arg, 1);
+        }else if constexpr (std::is_integral_v<T>){
+            write_Int_internal(arg);
+        }else if constexpr (std::is_floating_point_v<T>){
+            //NOTICE: to_chars() of the type itself. A float widened to double would print as 0.10000000149011612
+            write_chars_internal([arg](char* first, char* last){ return std::to_chars(first, last, arg); });
+        }else{
+            static_assert(std::is_convertible_v<const T&, std::string_view>, "write_Format() can't write this type");
+            const std::string_view text = arg;
+            writeBytes_internal(text.data(), text.size());
+        }
+    }
+
+
+    // Where in the file the next byte given to us will go.
+    size_t write_position()const{
+        //NOTICE: mutex is already locked.
+        return _appendOffset + (k_inMemory ? 0 : _next_ix_inBuff.load());
+    }
+
+    void markRecord_key_internal(int64_t key){
+        //NOTICE: mutex is already locked.
+        assert(_began);
+        if(_index.zoneBytes == 0){  _index.zoneBytes = _buffSizeBytes > 0 ? _buffSizeBytes : 1024*1024;  }
+        const size_t offset = write_position();
+        _index.add_record_key(offset, key);
+        _index.add_record(offset);
+        if(_bloomBitsPerKey > 0){  _bloomKeys.push_back({ offset / _index.zoneBytes,  chunk_index::hash_key(key) });  }
+    }
+
+
+    void markRecord_internal(){
+        //NOTICE: mutex is already locked.
+        assert(_began);
+        _index.add_record(write_position());
+    }
+
+
+    struct zone_key {  size_t zone;  uint64_t hash;  };
+
+    // Keys of the zones that end before 'offset'. No more records can start in those zones.
+    std::vector<zone_key> take_finished_bloomKeys(size_t offset){
+        //NOTICE: mutex is already locked.
+        if(_bloomKeys.empty()){ return {}; }
+        const size_t firstOpenZone = offset / _index.zoneBytes;
+        auto it = std::find_if(_bloomKeys.begin(), _bloomKeys.end(), [&](const zone_key& k){ return k.zone >= firstOpenZone; });
+        std::vector<zone_key> finished(_bloomKeys.begin(), it);
+        _bloomKeys.erase(_bloomKeys.begin(), it);
+        return finished;
+    }
+
+    // Runs on the flush tasks (and at the end, in completeWrite). 'keys' are sorted by zone.
+    void build_blooms(const std::vector<zone_key>& keys,  size_t bitsPerKey){
+        std::vector<uint64_t> hashes;
+        for(size_t i=0; i<keys.size(); ){
+            const size_t zone = keys[i].zone;
+            hashes.clear();
+            for(; i<keys.size() && keys[i].zone == zone; ++i){ hashes.push_back(keys[i].hash); }
+            std::vector<uint64_t> bits = chunk_index::build_bloom(hashes.data(), hashes.size(), bitsPerKey,
+                                                                  chunk_index::bloom_numHashes(bitsPerKey));
+            std::lock_guard bloomLck(_bloomMu);
+            if(_blooms.size() <= zone){ _blooms.resize(zone+1); }
+            _blooms[zone] = std::move(bits);
+        }
+    }
+
+    // After all the data. Then cuts the file, so the index is at its very end.
+    void write_index_footer(){
+        //NOTICE: mutex is already locked, buffers are flushed.
+        _index.dataBytes = _appendOffset;
+        if(_bloomBitsPerKey > 0){
+            build_blooms(_bloomKeys, _bloomBitsPerKey);//the last zones, no flush task made them
+            _bloomKeys.clear();
+            std::lock_guard bloomLck(_bloomMu);
+            _blooms.resize(_index.zones.size());
+            _index.blooms = std::move(_blooms);
+            _index.bloomHashes = chunk_index::bloom_numHashes(_bloomBitsPerKey);
+            _blooms.clear();
+        }
+        const std::vector<unsigned char> footer = _index.encode_footer();
+        _io.write_at(footer.data(), footer.size(), _appendOffset);
+        _appendOffset += footer.size();
+        _io.resize(_appendOffset);
+    }
+
+
+    void free_buffers(){
+        if(_buff_A != nullptr){ RawData_Buff::free_aligned(_buff_A); }
+        if(_buff_B != nullptr){ RawData_Buff::free_aligned(_buff_B); }
+        _buff_A = _buff_B = nullptr;
+    }
+
+
+    // The user's thread waits until this buffer is saved, before it can be reused.
+    void wait_for_writeTask(std::future<void>& task){
+        if(!task.valid()){ return; }
+        const chunk_event_span ev = _events.begin(chunk_io_event::producer_stall, _appendOffset/_buffSizeBytes);
+        task.get();
+        _events.end(ev);
+    }
+
+
 private:
+    static constexpr bool k_inMemory = is_in_memory_backend<Backend>::value;
+
     std::string _path_file_with_exten = "";
-    std::ofstream _f;
+    Backend _io;
+    size_t _appendOffset = 0;//where the next full buffer will be saved in the file. Only touched while '_mu' is locked.
 
     std::atomic_bool _began = false; //was beginWrite() called or not.
 
     size_t _buffSizeBytes = 0; //assigned once, during beginWrite().
+    size_t _buffAlignment = 16;
     unsigned char* _buff_A =nullptr;
     unsigned char* _buff_B =nullptr;
 
@@ -241,5 +659,18 @@ private:
     std::future<void> _writeTask_B;
 
     mutable std::mutex _mu;//for user interacting with us
-    mutable std::mutex _mu_fileAccess; //for cases when we are doing something with the _f variable.
+
+    chunk_event_sink<Hooks> _events;
+
+    chunk_index _index;//only if markRecord_key() or markRecord() was used
+    size_t _recordStride = 1024;//see set_recordStride()
+
+    size_t _bloomBitsPerKey = 0;//of the current file. 0 if no Bloom filters
+    size_t _bloomBitsPerKey_next = 0;//see enable_bloomFilters()
+    std::vector<zone_key> _bloomKeys;//of zones whose filter isn't built yet
+    std::mutex _bloomMu;//flush tasks put their filters into '_blooms'
+    std::vector<std::vector<uint64_t>> _blooms;
 };
+
+
+using file_writer_chunks = basic_file_writer_chunks<default_io_backend>;
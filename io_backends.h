@@ -0,0 +1,211 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17  for std::filesystem
+
+#pragma once
+#include <string>
+#include <fstream>
+#include <filesystem>
+#include <mutex>
+#include <atomic>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <cerrno>
+    #include <cstring>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/stat.h>
+    #include <sys/uio.h>
+#else
+    // Same layout as the POSIX one, for writeBytesv() / read_rawDatav()
+    struct iovec {
+        void*  iov_base;
+        size_t iov_len;
+    };
+#endif
+
+// Backends are what basic_file_read_chunks / basic_file_writer_chunks use to reach the bytes.
+// They are given as a template parameter, so there is no virtual dispatch.
+// Any class with the following members can be used:
+//
+//  Reader side:
+//      bool   open_read(const std::string& path)
+//      size_t size()const                                          total bytes in the source
+//      size_t read_at(void* dst, size_t numBytes, size_t offset)   returns num bytes actually read
+//
+//  Writer side:
+//      bool   open_write(const std::string& path, bool truncate)
+//      void   resize(size_t numBytes)                              throws if not possible
+//      size_t size()const
+//      void   write_at(const void* src, size_t numBytes, size_t offset)
+//
+//  Both:
+//      void   close()
+//      bool   is_open()const
+//
+//  Optional:
+//      static constexpr bool is_in_memory = true;   bytes are already in RAM (see memory_backends.h)
+//      const unsigned char*  data()const            reader: the entire source, no loading needed.
+//                                                   The chunk classes then skip their threads and buffers.
+//
+// Reads and writes are positional: the chunk classes decide where each chunk goes.
+// NOTICE: read_at() / write_at() can be invoked from our worker thread(s) while the user's thread
+// is calling other members. The writer might even have two write_at() in flight (one per buffer).
+
+
+template<typename Backend,  typename = void>
+struct is_in_memory_backend : std::false_type {};
+
+template<typename Backend>
+struct is_in_memory_backend<Backend,  std::enable_if_t<Backend::is_in_memory>> : std::true_type {};
+
+
+// Plain std::fstream. Positional access is emulated with seek + read/write under a mutex.
+class fstream_backend {
+public:
+    bool open_read(const std::string& path){
+        std::lock_guard lck(_mu);
+        _path = path;
+        _f.open(std::filesystem::path(path),  std::ios::in | std::ios::binary);
+        return _f.is_open();
+    }
+
+    bool open_write(const std::string& path,  bool truncate){
+        std::lock_guard lck(_mu);
+        _path = path;
+        //'in|out' opens an existing file without wiping it, but won't create a new one.
+        if(truncate || !std::filesystem::exists(path)){
+            _f.open(path,  std::ios::out | std::ios::trunc | std::ios::binary);
+        }else{
+            _f.open(path,  std::ios::in | std::ios::out | std::ios::binary);
+        }
+        return _f.is_open();
+    }
+
+    void close(){
+        std::lock_guard lck(_mu);
+        if(_f.is_open()){ _f.close(); }
+        _f.clear();
+    }
+
+    bool is_open()const{
+        std::lock_guard lck(_mu);
+        return _f.is_open();
+    }
+
+    size_t size()const{
+        std::lock_guard lck(_mu);
+        return std::filesystem::file_size(_path);//throws exception if path doesn't exist.
+    }
+
+    void resize(size_t numBytes){
+        std::lock_guard lck(_mu);
+        _f.flush();
+        std::filesystem::resize_file(_path, numBytes);
+    }
+
+    size_t read_at(void* dst,  size_t numBytes,  size_t offset){
+        std::lock_guard lck(_mu);
+        _f.clear();
+        _f.seekg(offset, std::ios_base::beg);
+        _f.read((char*)dst, numBytes);
+        return (size_t)_f.gcount();
+    }
+
+    void write_at(const void* src,  size_t numBytes,  size_t offset){
+        std::lock_guard lck(_mu);
+        //NOTICE: we will overwrite any consecutive bytes in a file, NOT insert. http://www.cplusplus.com/forum/beginner/150097/
+        _f.seekp(offset, std::ios_base::beg);
+        _f.write((const char*)src, numBytes);
+    }
+
+private:
+    std::fstream _f;
+    std::string _path;
+    mutable std::mutex _mu;//seek+read and seek+write must happen as one step.
+};
+
+
+#if defined(__unix__) || defined(__APPLE__)
+// Raw file descriptor with pread / pwrite.
+// Unlike fstream there is no internal filebuf (so no extra copy), and no lock:
+// pread/pwrite don't move a shared file position, so both of our threads can use the fd at once.
+class posix_fd_backend {
+public:
+    ~posix_fd_backend(){ close(); }
+
+    bool open_read(const std::string& path){
+        close();
+        _fd = ::open(path.c_str(),  O_RDONLY | O_CLOEXEC);
+    #if defined(POSIX_FADV_SEQUENTIAL)
+        if(_fd >= 0){ ::posix_fadvise(_fd, 0, 0, POSIX_FADV_SEQUENTIAL); }//bigger kernel readahead
+    #endif
+        return _fd >= 0;
+    }
+
+    bool open_write(const std::string& path,  bool truncate){
+        close();
+        _fd = ::open(path.c_str(),  O_WRONLY | O_CREAT | O_CLOEXEC | (truncate ? O_TRUNC : 0),  0644);
+        return _fd >= 0;
+    }
+
+    void close(){
+        const int fd = _fd.exchange(-1);
+        if(fd >= 0){ ::close(fd); }
+    }
+
+    bool is_open()const{ return _fd >= 0; }
+
+    size_t size()const{
+        struct stat st;
+        if(::fstat(_fd, &st) != 0){ throw_errno("fstat"); }
+        return (size_t)st.st_size;
+    }
+
+    void resize(size_t numBytes){
+        if(::ftruncate(_fd, (off_t)numBytes) != 0){ throw_errno("ftruncate"); }
+    }
+
+    // Keeps going until 'numBytes' are read or the end of file is reached.
+    // NOTICE: doesn't throw, because it runs on the reader's load thread. A short count means error/EOF.
+    size_t read_at(void* dst,  size_t numBytes,  size_t offset){
+        size_t done = 0;
+        while(done < numBytes){
+            const ssize_t got = ::pread(_fd, (char*)dst + done, numBytes - done, (off_t)(offset + done));
+            if(got < 0 && errno == EINTR){ continue; }
+            if(got <= 0){ break; }
+            done += (size_t)got;
+        }
+        return done;
+    }
+
+    // Throws on failure. The writer runs it inside std::async, so the exception
+    // arrives to the user at the next wait on that buffer (or at completeWrite).
+    void write_at(const void* src,  size_t numBytes,  size_t offset){
+        size_t done = 0;
+        while(done < numBytes){
+            const ssize_t put = ::pwrite(_fd, (const char*)src + done, numBytes - done, (off_t)(offset + done));
+            if(put < 0 && errno == EINTR){ continue; }
+            if(put <= 0){ throw_errno("pwrite"); }
+            done += (size_t)put;
+        }
+    }
+
+private:
+    static void throw_errno(const char* what){
+        throw std::runtime_error(std::string(what) + " failed: " + std::strerror(errno));
+    }
+
+private:
+    std::atomic<int> _fd = -1;
+};
+#endif
+
+
+#if defined(__linux__)
+    using default_io_backend = posix_fd_backend;
+#else
+    using default_io_backend = fstream_backend;
+#endif
@@ -0,0 +1,117 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <string>
+#include <cstring>
+#include <mutex>
+#include "io_backends.h"
+
+// Backends for bytes that are already in RAM: a decompressed blob, a network packet, etc.
+// Lets the same decoding code work whether the bytes came from disk or from memory.
+//
+//   memory_read_chunks reader;
+//   reader.BeginRead(blob.data(), blob.size());
+//   reader.read_Literal(header);   //...same as with file_read_chunks
+//
+//   memory_writer_chunks writer;
+//   writer.beginWrite("<memory>", 0);
+//   writer.writeBytes(...);
+//   writer.completeWrite();
+//   std::vector<unsigned char>& result = writer.backend().bytes();
+//
+// Both are 'is_in_memory', so the chunk classes don't spawn threads or double-buffer with them:
+// the reader reads straight from the region, the writer appends straight into the vector.
+// Wrapped into another backend (for example throttled_backend), they go through the usual chunked
+// path instead: read_at() / write_at() from worker threads, two writes in flight at once.
+
+
+// Non-owning view of a memory region. The region must stay alive until EndRead().
+class memory_source_backend {
+public:
+    static constexpr bool is_in_memory = true;
+
+    void set_source(const void* bytes,  size_t numBytes){
+        _data = (const unsigned char*)bytes;
+        _size = numBytes;
+    }
+
+    const unsigned char* data()const{ return _data; }
+
+    // 'path' is ignored, the region given to set_source() is used.
+    bool open_read(const std::string& /*path*/){
+        _isOpen = _data != nullptr  ||  _size == 0;
+        return _isOpen;
+    }
+
+    void close(){ _isOpen = false; }
+    bool is_open()const{ return _isOpen; }
+    size_t size()const{ return _size; }
+
+    //only used if someone wraps us into another backend (for example, throttled_backend).
+    size_t read_at(void* dst,  size_t numBytes,  size_t offset){
+        if(offset >= _size){ return 0; }
+        const size_t n = numBytes < _size-offset ? numBytes : _size-offset;
+        std::memcpy(dst, _data+offset, n);
+        return n;
+    }
+
+private:
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+    bool _isOpen = false;
+};
+
+
+// Growable sink. Unlike a file, 'startingFilesizeBytes' of beginWrite() only reserves capacity, 
+// so bytes() never contains the padding a file would have.
+// write_at() can be called from several threads at once: growing the vector moves it,
+// so copies into it and growth take turns (under '_mu'). Look at bytes() only after completeWrite().
+class memory_sink_backend {
+public:
+    static constexpr bool is_in_memory = true;
+
+    std::vector<unsigned char>& bytes(){ return _bytes; }
+    const std::vector<unsigned char>& bytes()const{ return _bytes; }
+
+    // 'path' is ignored. 'truncate' clears what was stored by the previous write.
+    bool open_write(const std::string& /*path*/,  bool truncate){
+        if(truncate){ _bytes.clear(); }
+        _isOpen = true;
+        return true;
+    }
+
+    void close(){ _isOpen = false; }
+    bool is_open()const{ return _isOpen; }
+    size_t size()const{
+        std::lock_guard lck(_mu);
+        return _bytes.size();
+    }
+
+    void resize(size_t numBytes){
+        std::lock_guard lck(_mu);
+        if(numBytes < _bytes.size()){ _bytes.resize(numBytes); }
+        else{ _bytes.reserve(numBytes); }
+    }
+
+    void write_at(const void* src,  size_t numBytes,  size_t offset){
+        //NOTICE: uncontended on the 'is_in_memory' path, there is only the user's thread.
+        std::lock_guard lck(_mu);
+        if(offset + numBytes > _bytes.size()){ _bytes.resize(offset + numBytes); }
+        std::memcpy(_bytes.data() + offset,  src,  numBytes);
+    }
+
+private:
+    std::vector<unsigned char> _bytes;
+    bool _isOpen = false;
+    mutable std::mutex _mu;//for write_at() from the writer's two flush tasks
+};
+
+
+#include "file_read_chunks.h"
+#include "file_write_chunks.h"
+
+using memory_read_chunks   = basic_file_read_chunks<memory_source_backend>;
+using memory_writer_chunks = basic_file_writer_chunks<memory_sink_backend>;
@@ -0,0 +1,50 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <cstring>
+#include <cstddef>
+#include <type_traits>
+
+// One field of a packed record, and the array where that field of every record should go.
+// Used by file_read_chunks::read_RecordsSoA() to turn records (array of structs) into
+// columns (struct of arrays):
+//
+//   struct Sample { int64_t time;  float temperature;  uint16_t sensor; };
+//   std::vector<int64_t> times(n);   std::vector<float> temps(n);
+//   reader.read_RecordsSoA<Sample>(n,  soa_column(&Sample::time, times.data()),
+//                                      soa_column(&Sample::temperature, temps.data()));
+//
+// Fields you don't ask for are skipped.
+template<typename Rec,  typename M>
+struct soa_column {
+    static_assert(std::is_trivially_copyable_v<Rec>,  "records must be plain bytes");
+    using record_type = Rec;
+
+    soa_column(M Rec::* member,  M* dst)
+        :dst(dst),  offset(offset_of(member)){
+    }
+
+    // Copies this field of 'numRecords' consecutive records into dst[dstIx...]
+    // NOTICE: a strided loop over a small block of records. The compiler vectorizes it
+    // (strided loads + shuffles), and the block is still in L1 for the next column.
+    void scatter(const unsigned char* records,  size_t numRecords,  size_t dstIx)const{
+        M* out = dst + dstIx;
+        const unsigned char* src = records + offset;
+        for(size_t i=0; i<numRecords; ++i){
+            std::memcpy(out + i,  src + i*sizeof(Rec),  sizeof(M));
+        }
+    }
+
+    M* dst;
+    size_t offset;//of the field, in the record
+
+private:
+    static size_t offset_of(M Rec::* member){
+        //offsetof() doesn't take a member pointer, so measure it on some storage:
+        alignas(Rec) unsigned char storage[sizeof(Rec)];
+        const Rec* r = reinterpret_cast<const Rec*>(storage);
+        return (size_t)(reinterpret_cast<const unsigned char*>(&(r->*member)) - storage);
+    }
+};
@@ -0,0 +1,94 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <vector>
+#include <memory>
+#include <cstring>
+#include <string_view>
+
+// Bump allocator for lots of short strings. Each string is just placed after the previous one,
+// in big blocks. Nothing is freed one by one: reset() makes all of it reusable at once.
+//
+//   string_arena arena;
+//   std::string_view name = reader.read_String(arena, numChars);
+//   ...
+//   arena.reset();   //all views from it are now invalid
+//
+// Views stay valid until reset() or release(). Adding more strings never moves the old ones.
+class string_arena {
+public:
+    explicit string_arena(size_t blockBytes = 1024*1024)
+        :_blockBytes(blockBytes){
+    }
+
+    string_arena(const string_arena& other) = delete;
+    string_arena& operator=(const string_arena& other) = delete;
+    string_arena(string_arena&& other) = default;
+    string_arena& operator=(string_arena&& other) = default;
+
+
+    // Uninitialized room for 'numBytes'
+    char* allocate(size_t numBytes){
+        while(_blockIx < _blocks.size()){
+            block& b = _blocks[_blockIx];
+            if(_used + numBytes <= b.size){
+                char* p = b.data.get() + _used;
+                _used += numBytes;
+                _numBytes += numBytes;
+                return p;
+            }
+            //doesn't fit the rest of this block. Try the next one (kept from before a reset):
+            ++_blockIx;
+            _used = 0;
+        }
+        const size_t size = numBytes > _blockBytes ? numBytes : _blockBytes;
+        _blocks.push_back({ std::unique_ptr<char[]>(new char[size]),  size });
+        _blockIx = _blocks.size() - 1;
+        _used = numBytes;
+        _numBytes += numBytes;
+        return _blocks.back().data.get();
+    }
+
+    std::string_view store(std::string_view text){
+        char* p = allocate(text.size());
+        if(!text.empty()){ std::memcpy(p, text.data(), text.size()); }
+        return std::string_view(p, text.size());
+    }
+
+
+    // Forgets every string, but keeps the blocks for the next ones (no frees, no mallocs).
+    void reset(){
+        _blockIx = 0;
+        _used = 0;
+        _numBytes = 0;
+    }
+
+    // Same as reset(), and gives the memory back.
+    void release(){
+        _blocks.clear();
+        reset();
+    }
+
+    size_t numBytes_used()const{ return _numBytes; }//of the strings stored since reset()
+
+    size_t numBytes_allocated()const{
+        size_t total = 0;
+        for(const block& b : _blocks){ total += b.size; }
+        return total;
+    }
+
+
+private:
+    struct block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<block> _blocks;
+    size_t _blockIx = 0;//which block we are filling
+    size_t _used = 0;//bytes used in that block
+    size_t _numBytes = 0;
+    size_t _blockBytes;
+};
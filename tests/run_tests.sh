@@ -0,0 +1,23 @@
+#!/bin/sh
+# Builds and runs every tests/test_*.cpp.  Exits with 1 if any of them failed.
+#
+#   tests/run_tests.sh                              plain build
+#   CXXFLAGS="-mavx2" tests/run_tests.sh            SIMD paths (utf8_validate.h, csv_tokenizer.h)
+#   CXXFLAGS="-fsanitize=thread -g" tests/run_tests.sh
+
+cd "$(dirname "$0")" || exit 1
+CXX=${CXX:-g++}
+OUT=${OUT:-${TMPDIR:-/tmp}/chunked_rw_tests}
+mkdir -p "$OUT"
+
+failed=0
+for src in test_*.cpp; do
+    name=${src%.cpp}
+    if ! $CXX -std=c++17 -O2 -Wall -Wextra -pthread -I.. $CXXFLAGS "$src" -o "$OUT/$name"; then
+        echo "BUILD FAILED  $name";  failed=1;  continue
+    fi
+    if "$OUT/$name"; then echo "ok      $name"
+    else                  echo "FAILED  $name";  failed=1
+    fi
+done
+exit $failed
@@ -0,0 +1,128 @@
+// Numbers as text: write_Int() / write_Double() / write_Format(), read back with
+// read_AsciiInt() / read_AsciiDouble(), also when a number is cut by a chunk boundary,
+// or followed by text that isn't part of it (12abc, 3.5px).
+#include "test_common.h"
+#include "../file_write_chunks.h"
+#include "../file_read_chunks.h"
+#include "../memory_backends.h"
+#include <cmath>
+#include <cstring>
+
+static void test_round_trip(){
+    const std::string path = temp_path("numbers.txt");
+    const int N = 50000;
+    auto int_of = [](int i){ return (long long)i*i * (i%2 ? -1 : 1) * 12345; };
+    auto double_of = [](int i){ return std::sin(i) * std::pow(10.0, i%40 - 20); };
+    {
+        file_writer_chunks w;
+        w.beginWrite(path, 0, std::ios::trunc, 1024);
+        for(int i=0; i<N; ++i){
+            w.write_Int(int_of(i));
+            w.write_Format(i%3 ? " , " : "\n\t");
+            w.write_Double(double_of(i));
+            w.write_Format(";");
+        }
+        w.completeWrite();
+    }
+    for(size_t chunkBytes : {size_t(4096), size_t(1 << 20)}){
+        file_read_chunks r(chunkBytes);
+        r.BeginRead(path);
+        for(int i=0; i<N; ++i){
+            long long v;
+            double d;
+            r.read_AsciiInt(v);
+            r.skip_Chars(" ,\n\t");
+            r.read_AsciiDouble(d);
+            r.skip_Chars(";");
+            CHECK(v == int_of(i));
+            CHECK(d == double_of(i));//shortest form reads back exactly
+        }
+        CHECK(!r.skip_Whitespace());
+        int past;
+        CHECK_THROWS(r.read_AsciiInt(past));
+    }
+}
+
+
+static void test_format(){
+    memory_writer_chunks w;
+    w.beginWrite("<memory>", 0);
+    w.write_Format("{} {} {} {} {}", 0.1f, 0.1, 1e30f, -42, "text");
+    w.completeWrite();
+    const std::vector<unsigned char>& b = w.backend().bytes();
+    CHECK(std::string(b.begin(), b.end()) == "0.1 0.1 1e+30 -42 text");
+    CHECK_THROWS(w.write_Format("{} {}", 1));
+}
+
+
+// Like strtol / strtod: the longest prefix that is a number, the rest is left for the next read.
+static void test_prefix(){
+    const std::string path = temp_path("units.txt");
+    const int N = 50000;
+    {
+        file_writer_chunks w;
+        w.beginWrite(path, 0, std::ios::trunc, 1024);
+        for(int i=0; i<N; ++i){ w.write_Format("+{}abc {}px\n",  i,  i * 0.25); }
+        w.completeWrite();
+    }
+    file_read_chunks r(4096);//lots of numbers cut by a chunk boundary
+    r.BeginRead(path);
+    for(int i=0; i<N; ++i){
+        int v;
+        double d;
+        r.read_AsciiInt(v);
+        CHECK(v == i);
+        CHECK(r.skip_Chars("abc "));
+        r.read_AsciiDouble(d);
+        CHECK(d == i * 0.25);
+        r.skip_Chars("px\n");
+    }
+
+    struct Case { const char* text;  double value;  size_t numLeft; };
+    const Case cases[] = {
+        { "2e",  2,  1 },   { "2e+x",  2,  3 },   { "2e+3x",  2000,  1 },   { "-.5;",  -0.5,  1 },
+        { "5.",  5,  0 },   { "INFINITY",  INFINITY,  0 },   { "infx",  INFINITY,  1 },
+    };
+    for(const Case& c : cases){
+        memory_read_chunks m;
+        m.BeginRead(c.text, std::strlen(c.text));
+        double d;
+        m.read_AsciiDouble(d);
+        CHECK(d == c.value);
+        CHECK(m.remainingBytes_total() == c.numLeft);
+    }
+    memory_read_chunks m;
+    m.BeginRead("nan", 3);
+    double d;
+    m.read_AsciiDouble(d);
+    CHECK(std::isnan(d));
+}
+
+
+static void test_errors(){
+    const char* text = " 12 x3 99999999999 +-5 1e400 .";
+    memory_read_chunks r;
+    r.BeginRead(text, std::strlen(text));
+    int a;
+    r.read_AsciiInt(a);
+    CHECK(a == 12);
+    CHECK_THROWS(r.read_AsciiInt(a));//x3
+    r.skip_Chars(" x3");
+    CHECK_THROWS(r.read_AsciiInt(a));//doesn't fit into int
+    r.skip_Chars(" 9");
+    CHECK_THROWS(r.read_AsciiInt(a));//+-5
+    r.skip_Chars(" +-5");
+    double d;
+    CHECK_THROWS(r.read_AsciiDouble(d));//1e400
+    r.skip_Chars(" 1e40");
+    CHECK_THROWS(r.read_AsciiDouble(d));//.
+}
+
+
+int main(){
+    test_round_trip();
+    test_format();
+    test_prefix();
+    test_errors();
+    return 0;
+}
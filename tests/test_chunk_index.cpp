@@ -0,0 +1,215 @@
+// The chunk_index footer: zones with key ranges, Bloom filters, record offsets,
+// and the footer encoding itself (including sections a newer writer might add).
+#include "test_common.h"
+#include "../file_write_chunks.h"
+#include "../file_read_chunks.h"
+#include "../memory_backends.h"
+#include <random>
+
+struct Rec { int64_t key;  int32_t v;  int32_t pad; };
+
+
+static void test_zones(){
+    const std::string path = temp_path("zones.bin");
+    const int N = 200000;
+    auto key_of = [](int i){ return (int64_t)i*3 + i%7; };
+    {
+        file_writer_chunks w;
+        w.beginWrite(path, 64 << 20, std::ios::trunc, 4096);//the padding must be cut off by completeWrite()
+        for(int i=0; i<N; ++i){
+            auto b = w.batch();
+            b.markRecord_key(key_of(i));
+            b.write_Literal(Rec{ key_of(i), i, 0 });
+        }
+        w.completeWrite();
+    }
+    CHECK(std::filesystem::file_size(path) < N*sizeof(Rec) + 200000);
+
+    //sequential read stops where the data ends, not at the footer
+    {
+        file_read_chunks r(8192);
+        r.BeginRead(path);
+        CHECK(r.load_index());
+        int n = 0;
+        while(r.HasMoreForRead()){
+            Rec x;
+            r.read_Literal(x);
+            CHECK(x.v == n);
+            ++n;
+        }
+        CHECK(n == N);
+    }
+    for(size_t chunkBytes : {size_t(4096), size_t(1 << 20)}){
+        file_read_chunks r(chunkBytes);
+        r.BeginReadAt(path);
+        CHECK(r.load_index());
+        const int64_t lo = 300000,  hi = 300500;
+        int found = 0,  expected = 0;
+        r.for_each_record_inKeyRange(lo, hi, [&]{
+            Rec x;
+            r.read_Literal(x);
+            if(x.key >= lo && x.key <= hi){ ++found; }
+        });
+        for(int i=0; i<N; ++i){  expected += key_of(i) >= lo && key_of(i) <= hi;  }
+        CHECK(found == expected);
+    }
+    //a file without an index
+    {
+        const std::string plain = temp_path("no_index.bin");
+        file_writer_chunks w;
+        w.beginWrite(plain, 0, std::ios::trunc, 4096);
+        for(int i=0; i<1000; ++i){ w.write_Literal(i); }
+        w.completeWrite();
+        file_read_chunks r(4096);
+        r.BeginRead(plain);
+        CHECK(!r.load_index());
+        CHECK(r.fileByteSize() == 1000*sizeof(int));
+    }
+}
+
+
+static void test_blooms(){
+    const std::string path = temp_path("blooms.bin");
+    const int N = 100000;
+    std::vector<int64_t> keys(N);
+    std::mt19937_64 rng(5);
+    for(int64_t& k : keys){ k = (int64_t)(rng() >> 2); }
+    {
+        file_writer_chunks w;
+        w.enable_bloomFilters();
+        w.beginWrite(path, 1024, std::ios::trunc, 4096);
+        for(int i=0; i<N; ++i){
+            w.markRecord_key(keys[i]);
+            w.write_Literal(Rec{ keys[i], i, 0 });
+        }
+        w.completeWrite();
+    }
+    file_read_chunks r(4096);
+    r.BeginReadAt(path);
+    CHECK(r.load_index());
+    CHECK(!r.index().blooms.empty());
+    for(int i : {0, 1, 4567, N/2, N-1}){//no false negatives
+        int found = 0;
+        r.lookup(keys[i], [&]{
+            Rec x;
+            r.read_Literal(x);
+            found += x.key == keys[i];
+        });
+        CHECK(found == 1);
+    }
+
+    //enabled in the middle of a file: takes effect from the next beginWrite()
+    const std::string mid = temp_path("blooms_mid.bin");
+    file_writer_chunks w;
+    w.beginWrite(mid, 1024, std::ios::trunc, 4096);
+    for(int i=0; i<4000; ++i){
+        if(i == 2000){ w.enable_bloomFilters(); }
+        w.markRecord_key(i);
+        w.write_Literal(i);
+    }
+    w.completeWrite();
+    file_read_chunks m(4096);
+    m.BeginReadAt(mid);
+    CHECK(m.load_index());
+    CHECK(m.index().blooms.empty());
+    int found = 0;
+    m.lookup(10, [&]{ int v;  m.read_Literal(v);  found += v == 10; });
+    CHECK(found == 1);
+}
+
+
+static void test_records(){
+    auto text = [](int i){ return std::string((size_t)(i*7919) % 300,  char('a' + i%26)); };
+    const std::string path = temp_path("records.bin");
+    const int N = 50000;
+    {
+        file_writer_chunks w;
+        w.set_recordStride(100);
+        w.beginWrite(path, 1024, std::ios::trunc, 4096);
+        for(int i=0; i<N; ++i){
+            const std::string s = text(i);
+            auto b = w.batch();
+            b.markRecord();
+            b.write_Literal(i);
+            b.write_Literal((uint32_t)s.size());
+            b.writeBytes(s.data(), s.size());
+        }
+        w.completeWrite();
+    }
+    file_read_chunks r(4096);
+    r.BeginReadAt(path);
+    CHECK(r.load_index());
+    CHECK(r.numRecords() == N);
+    CHECK(r.index().recordOffsets.size() == N/100);
+    std::mt19937 rng(3);
+    for(int t=0; t<300; ++t){
+        const int i =  t == 0 ? N-1 :  t == 1 ? 0 :  (int)(rng() % N);
+        const size_t skip = r.seekToRecord(i);
+        CHECK(skip == (size_t)(i % 100));
+        for(size_t k=0; k<=skip; ++k){
+            int id;
+            uint32_t len;
+            std::string s;
+            r.read_Literal(id);
+            r.read_Literal(len);
+            r.read_String(s, len);
+            CHECK(id == i - (int)skip + (int)k);
+            CHECK(s == text(id));
+        }
+    }
+    CHECK_THROWS(r.seekToRecord(N));
+}
+
+
+static void test_footer_encoding(){
+    chunk_index ix;
+    ix.dataBytes = 5000;
+    ix.zoneBytes = 1000;
+    for(int i=0; i<5000; i+=10){ ix.add_record_key(i, 7*i); }
+    ix.recordStride = 3;
+    ix.numRecords = 10;
+    ix.recordOffsets = { 0, 200, 100000, 100001 };
+
+    std::vector<unsigned char> footer = ix.encode_footer();
+
+    //a section from a newer version, in front of the others: must be skipped
+    std::vector<unsigned char> unknown(32, 0xAB);
+    chunk_index::byte_sink s;
+    s.section(99, unknown);
+    footer.insert(footer.begin(), s.bytes.begin(), s.bytes.end());
+
+    chunk_index back;
+    back.decode_footer(footer.data(), footer.size());
+    CHECK(back.zoneBytes == ix.zoneBytes);
+    CHECK(back.zones.size() == ix.zones.size());
+    for(size_t z=0; z<ix.zones.size(); ++z){
+        CHECK(back.zones[z].minKey == ix.zones[z].minKey);
+        CHECK(back.zones[z].maxKey == ix.zones[z].maxKey);
+        CHECK(back.zones[z].numRecords == ix.zones[z].numRecords);
+    }
+    CHECK(back.recordStride == 3);
+    CHECK(back.numRecords == 10);
+    CHECK(back.recordOffsets == ix.recordOffsets);
+
+    //without a filter a zone can't be ruled out, an empty filter rules out everything
+    chunk_index b;
+    b.zoneBytes = 100;
+    b.add_record_key(0, 5);
+    b.add_record_key(150, 5);
+    b.bloomHashes = 3;
+    b.blooms.resize(2);
+    b.blooms[1] = chunk_index::build_bloom(nullptr, 0, 10, 3);
+    CHECK(b.zone_mightContain(0, 5));
+    CHECK(!b.zone_mightContain(1, 5));
+
+    CHECK_THROWS(back.decode_footer(footer.data(), 3));
+}
+
+
+int main(){
+    test_zones();
+    test_blooms();
+    test_records();
+    test_footer_encoding();
+    return 0;
+}
@@ -0,0 +1,98 @@
+// serialize() / deserialize(): nested containers and chunk_schema structs, through files and memory.
+#include "test_common.h"
+#include "../file_write_chunks.h"
+#include "../file_read_chunks.h"
+#include "../memory_backends.h"
+#include "../chunk_serialize.h"
+
+struct Pod { int32_t a;  float b;  char c[3]; };
+
+struct Person {
+    std::string name;
+    int32_t age;
+    std::vector<std::string> tags;
+    std::array<Pod, 2> pods;
+
+    bool operator==(const Person& o)const{
+        return name == o.name  &&  age == o.age  &&  tags == o.tags  &&  pods[1].a == o.pods[1].a;
+    }
+};
+template<> struct chunk_schema<Person> {
+    static constexpr auto members = std::make_tuple(&Person::name, &Person::age, &Person::tags, &Person::pods);
+};
+
+//members in a different order than declared
+struct Swapped { int32_t x;  int32_t y;  std::string s; };
+template<> struct chunk_schema<Swapped> {
+    static constexpr auto members = std::make_tuple(&Swapped::y, &Swapped::x, &Swapped::s);
+};
+
+
+static void test_nested(){
+    using Table = std::vector<std::pair<std::string, std::tuple<int, std::vector<double>, Person>>>;
+    Table t;
+    for(int i=0; i<3000; ++i){
+        Person p{ "p" + std::to_string(i),  i,  {"a", "bb", std::string(i % 50, 'z')},  {} };
+        p.pods[1].a = i;
+        t.push_back({ std::to_string(i),  { i, std::vector<double>(i % 20, i * 0.5), p } });
+    }
+    const std::string path = temp_path("serialize.bin");
+    {
+        file_writer_chunks w;
+        w.beginWrite(path, 0, std::ios::trunc, 4096);
+        {
+            auto b = w.batch();
+            serialize(b, t);
+        }
+        serialize(w, 42);
+        w.completeWrite();
+    }
+    file_read_chunks r(4096);
+    r.BeginRead(path);
+    Table back;
+    int x = 0;
+    deserialize(r, back);
+    deserialize(r, x);
+    CHECK(back == t);
+    CHECK(x == 42);
+    CHECK(!r.HasMoreForRead());
+}
+
+
+static void test_schema_order_and_corruption(){
+    memory_writer_chunks w;
+    w.beginWrite("<memory>", 0);
+    serialize(w, Swapped{ 5, 6, "s" });
+    serialize(w, std::string("hello"));
+    w.completeWrite();
+    std::vector<unsigned char> bytes = w.backend().bytes();
+
+    int32_t first;
+    std::memcpy(&first, bytes.data(), sizeof(first));
+    CHECK(first == 6);//'y' goes first
+
+    memory_read_chunks r;
+    r.BeginRead(bytes.data(), bytes.size());
+    Swapped s{};
+    std::string hello;
+    deserialize(r, s);
+    deserialize(r, hello);
+    CHECK(s.x == 5  &&  s.y == 6  &&  s.s == "s");
+    CHECK(hello == "hello");
+
+    //a length that is larger than what is left must throw, not allocate
+    const size_t lengthAt = 2*sizeof(int32_t) + sizeof(uint64_t) + 1;
+    bytes[lengthAt] = 0xff;
+    bytes[lengthAt + 7] = 0x7f;
+    memory_read_chunks bad;
+    bad.BeginRead(bytes.data(), bytes.size());
+    deserialize(bad, s);
+    CHECK_THROWS(deserialize(bad, hello));
+}
+
+
+int main(){
+    test_nested();
+    test_schema_order_and_corruption();
+    return 0;
+}
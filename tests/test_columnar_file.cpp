@@ -0,0 +1,84 @@
+// columnar_writer / columnar_reader: whole columns, chunk by chunk, and a writer reused for several files.
+#include "test_common.h"
+#include "../columnar_file.h"
+#include <array>
+
+static void test_round_trip(){
+    const std::string path = temp_path("columns.col");
+    const int N = 300000;
+    {
+        columnar_writer w(4096);
+        w.beginWrite(path, {"time", "price", "qty", "blob"});
+        for(int i=0; i<N; ++i){
+            w.write_Value(0, (int64_t)i * 10);
+            w.write_Value(1, i * 0.5);
+            w.write_Value(2, (int32_t)(i % 100));
+            w.writeBytes(3, "abc", i % 4);
+        }
+        w.completeWrite();
+    }
+    columnar_reader r;
+    r.open(path);
+    CHECK(r.numColumns() == 4);
+    CHECK(r.columnName(1) == "price");
+
+    std::vector<double> prices;
+    r.read_Column(r.column_index("price"), prices);
+    CHECK((int)prices.size() == N);
+    for(int i=0; i<N; ++i){ CHECK(prices[i] == i * 0.5); }
+
+    std::vector<int32_t> qty;
+    r.read_Column(2, qty);
+    CHECK((int)qty.size() == N);
+    CHECK(qty[12345] == 45);
+
+    size_t seen = 0;
+    int64_t expected = 0;
+    r.for_each_chunk(0, [&](const unsigned char* bytes, size_t numBytes){
+        for(size_t k=0; k<numBytes; k+=sizeof(int64_t)){
+            int64_t v;
+            std::memcpy(&v, bytes + k, sizeof(v));
+            CHECK(v == expected);
+            expected += 10;
+        }
+        seen += numBytes;
+    });
+    CHECK(seen == N * sizeof(int64_t));
+
+    size_t blobBytes = 0;
+    for(int i=0; i<N; ++i){ blobBytes += i % 4; }
+    CHECK(r.columnBytes(3) == blobBytes);
+
+    CHECK_THROWS(r.column_index("nope"));
+    std::vector<std::array<char, 7>> wrongSize;//doesn't divide the column's bytes
+    CHECK_THROWS(r.read_Column(3, wrongSize));
+}
+
+
+static void test_writer_reuse(){
+    columnar_writer w(256);
+    for(int round=0; round<3; ++round){
+        w.beginWrite(temp_path("reuse" + std::to_string(round) + ".col"), {"a", "b"});
+        for(int i=0; i<1000 + round*100; ++i){
+            w.write_Value(0, i);
+            w.write_Value(1, i * 0.5);
+        }
+        w.completeWrite();
+    }
+    for(int round=0; round<3; ++round){
+        columnar_reader r;
+        r.open(temp_path("reuse" + std::to_string(round) + ".col"));
+        std::vector<double> b;
+        r.read_Column(1, b);
+        CHECK(b.size() == (size_t)(1000 + round*100));
+        CHECK(b.back() == (b.size() - 1) * 0.5);
+    }
+    CHECK_THROWS(columnar_writer(0));
+}
+
+
+int main(){
+    test_round_trip();
+    test_writer_reuse();
+    return 0;
+}
@@ -0,0 +1,34 @@
+// MIT LICENSE
+// Requires C++17
+#pragma once
+#include "../bench/standalone_shims.h"//LogConsole, nn_dev_assert
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <filesystem>
+
+// Each test is a small program: main() returns 0 if everything passed.
+// CHECK() stops at the first failure, and says where it was.
+#define CHECK(cond)  do{ \
+        if(!(cond)){ \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            std::exit(1); \
+        } \
+    }while(0)
+
+// Runs 'expr', expecting it to throw std::runtime_error.
+#define CHECK_THROWS(expr)  do{ \
+        bool threw_ = false; \
+        try{ expr; }catch(const std::runtime_error&){ threw_ = true; } \
+        if(!threw_){ \
+            std::fprintf(stderr, "%s:%d: CHECK_THROWS(%s) didn't throw\n", __FILE__, __LINE__, #expr); \
+            std::exit(1); \
+        } \
+    }while(0)
+
+
+// A file in the temp directory. The tests overwrite it freely.
+inline std::string temp_path(const std::string& name){
+    return (std::filesystem::temp_directory_path() / ("chunked_rw_test_" + name)).string();
+}
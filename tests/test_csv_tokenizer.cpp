@@ -0,0 +1,105 @@
+// csv_tokenizer: random rows with quotes, "" escapes, delimiters and line breaks inside fields,
+// text after a closing quote and \r\n endings. Read from small chunks (rows cross chunks) and from memory.
+// Build with -mavx2 to test the AVX2 path too (see run_tests.sh).
+#include "test_common.h"
+#include "../file_read_chunks.h"
+#include "../memory_backends.h"
+#include "../csv_tokenizer.h"
+#include <fstream>
+#include <random>
+#include <cstring>
+
+using Rows = std::vector<std::vector<std::string>>;
+
+template<typename Reader>
+static void check_rows(Reader& reader,  const Rows& expected,  char delimiter = ','){
+    csv_tokenizer csv(reader, delimiter);
+    std::vector<std::string_view> fields;
+    size_t i = 0;
+    while(csv.read_Row(fields)){
+        CHECK(i < expected.size());
+        CHECK(fields.size() == expected[i].size());
+        for(size_t k=0; k<fields.size(); ++k){ CHECK(fields[k] == expected[i][k]); }
+        ++i;
+    }
+    CHECK(i == expected.size());
+    CHECK(csv.numRows() == expected.size());
+}
+
+
+static void test_random_rows(){
+    std::mt19937 rng(5);
+    Rows rows;
+    std::string text;
+    for(int r=0; r<30000; ++r){
+        std::vector<std::string> row;
+        const int numFields = 1 + rng() % 6;
+        for(int f=0; f<numFields; ++f){
+            const bool quoted = rng() % 4 == 0;
+            const char* alphabet =  quoted ? "abc,\"\n\r x" : "abcdefgh 123";
+            std::string v;
+            const int len = rng() % 40;
+            for(int k=0; k<len; ++k){ v += alphabet[rng() % std::strlen(alphabet)]; }
+            if(quoted){
+                text += '"';
+                for(char c : v){ text += c == '"' ? std::string("\"\"") : std::string(1, c); }
+                text += '"';
+                if(rng() % 8 == 0){//a few characters after the closing quote
+                    const std::string tail(1 + rng() % 3,  'x');
+                    text += tail;
+                    v += tail;
+                }
+            }else{
+                text += v;
+            }
+            row.push_back(v);
+            if(f + 1 < numFields){ text += ','; }
+        }
+        text += r % 2 ? "\r\n" : "\n";
+        rows.push_back(row);
+    }
+    //the last row without a line break
+    text.pop_back();
+    if(text.back() == '\r'){ text.pop_back(); }
+
+    const std::string path = temp_path("rows.csv");
+    {
+        std::ofstream f(path, std::ios::binary);
+        f << text;
+    }
+    for(size_t chunkBytes : {size_t(4096), size_t(1 << 20)}){
+        file_read_chunks r(chunkBytes);
+        r.BeginRead(path);
+        check_rows(r, rows);
+    }
+    memory_read_chunks m;
+    m.BeginRead(text.data(), text.size());
+    check_rows(m, rows);
+}
+
+
+static void test_cases(){
+    struct Case { const char* text;  Rows rows;  char delimiter; };
+    const Case cases[] = {
+        { "a\tb\n\nc",             {{"a", "b"}, {""}, {"c"}},          '\t' },
+        { "a,b\r\n",               {{"a", "b"}},                       ',' },
+        { "x\"y,\"q\"\"\"\n",      {{"x\"y", "q\""}},                  ',' },//a quote in the middle is a character
+        { "\"a\r\n\",b\r\n",       {{"a\r\n", "b"}},                   ',' },
+        { "\"unterminated,x\n",    {{"unterminated,x\n"}},             ',' },
+        { ",,\n",                  {{"", "", ""}},                     ',' },
+        { "\"ab\"c,\"x\"\"y\" z\r\n", {{"abc", "x\"y z"}},             ',' },//text after the closing quote is kept
+        { "\"\"x,\"ab\"\r\n",       {{"x", "ab"}},                      ',' },
+    };
+    for(const Case& c : cases){
+        memory_read_chunks m;
+        m.BeginRead(c.text, std::strlen(c.text));
+        check_rows(m, c.rows, c.delimiter);
+    }
+}
+
+
+int main(){
+    test_random_rows();
+    test_cases();
+    return 0;
+}
@@ -0,0 +1,132 @@
+// Round trip through file_writer_chunks / file_read_chunks: values that cross chunk boundaries,
+// files smaller than a chunk or exactly one chunk, empty files, seek, and in-memory bytes.
+#include "test_common.h"
+#include "../file_write_chunks.h"
+#include "../file_read_chunks.h"
+#include "../memory_backends.h"
+#include <fstream>
+#include <vector>
+
+struct Odd { int32_t a;  char c[3]; };//7 bytes, so it regularly straddles two chunks
+
+
+static void test_literals(){
+    const std::string path = temp_path("literals.bin");
+    const int N = 100000;
+    {
+        file_writer_chunks w;
+        w.beginWrite(path, 0, std::ios::trunc, 4096);
+        for(int i=0; i<N; ++i){
+            Odd o{ i, {'a', 'b', (char)i} };
+            w.write_Literal(o);
+            const std::string s(i % 37, char('a' + i%26));
+            w.write_Literal((uint8_t)s.size());
+            w.writeBytes(s.data(), s.size());
+        }
+        const int patched = -7;
+        w.overwriteBytes_slow(0, &patched, sizeof(patched));
+        w.completeWrite();
+    }
+    for(size_t chunkBytes : {size_t(4096), size_t(1 << 20)}){
+        file_read_chunks r(chunkBytes);
+        r.BeginRead(path);
+        for(int i=0; i<N; ++i){
+            Odd o;
+            uint8_t len;
+            std::string s;
+            r.read_Literal(o);
+            r.read_Literal(len);
+            r.read_String(s, len);
+            CHECK(o.a == (i == 0 ? -7 : i));
+            CHECK(o.c[2] == (char)i);
+            CHECK(s == std::string(i % 37, char('a' + i%26)));
+        }
+        CHECK(!r.HasMoreForRead());
+    }
+}
+
+
+static void test_small_and_empty_files(){
+    std::vector<int32_t> v(1024);
+    for(int i=0; i<1024; ++i){ v[i] = i; }
+
+    const std::string empty = temp_path("empty.bin");
+    const std::string exact = temp_path("exact.bin");
+    const std::string small = temp_path("small.bin");
+    { std::ofstream f(empty, std::ios::binary | std::ios::trunc); }
+    { std::ofstream f(exact, std::ios::binary);  f.write((const char*)v.data(), 4096); }
+    { std::ofstream f(small, std::ios::binary);  f.write((const char*)v.data(), 100); }
+
+    for(size_t chunkBytes : {size_t(0), size_t(4096)}){//0 means "the default size"
+        file_read_chunks r(chunkBytes);
+        r.BeginRead(empty);
+        CHECK(!r.HasMoreForRead());
+        r.seek(0);
+        CHECK(!r.HasMoreForRead());
+        CHECK(!r.load_index());
+
+        for(const std::string& p : {exact, small}){//the same reader, reused
+            r.BeginRead(p);
+            const size_t n = r.fileByteSize() / sizeof(int32_t);
+            for(size_t i=0; i<n; ++i){
+                int32_t x;
+                r.read_Literal(x);
+                CHECK(x == (int32_t)i);
+            }
+            CHECK(!r.HasMoreForRead());
+            int32_t past;
+            CHECK_THROWS(r.read_Literal(past));
+        }
+    }
+}
+
+
+static void test_seek(){
+    const std::string path = temp_path("seek.bin");
+    const int N = 200000;
+    {
+        file_writer_chunks w;
+        w.beginWrite(path, 0, std::ios::trunc, 4096);
+        for(int i=0; i<N; ++i){ w.write_Literal(i); }
+        w.completeWrite();
+    }
+    file_read_chunks r(4096);
+    r.BeginReadAt(path);
+    for(int i : {12345, 0, N-1, 1023, 1024, 77777}){
+        r.seek(sizeof(int) * i);
+        CHECK(r.readPosition() == sizeof(int) * i);
+        int x;
+        r.read_Literal(x);
+        CHECK(x == i);
+    }
+    r.seek(r.fileByteSize());
+    CHECK(!r.HasMoreForRead());
+}
+
+
+static void test_memory(){
+    memory_writer_chunks w;
+    w.beginWrite("<memory>", 0);
+    for(int i=0; i<100000; ++i){ w.write_Literal(i); }
+    w.completeWrite();
+    const std::vector<unsigned char>& bytes = w.backend().bytes();
+    CHECK(bytes.size() == 100000 * sizeof(int));
+
+    memory_read_chunks r;
+    r.BeginRead(bytes.data(), bytes.size());
+    for(int i=0; i<100000; ++i){
+        int x;
+        r.read_Literal(x);
+        CHECK(x == i);
+    }
+    CHECK(!r.HasMoreForRead());
+}
+
+
+int main(){
+    test_literals();
+    test_small_and_empty_files();
+    test_seek();
+    test_memory();
+    return 0;
+}
@@ -0,0 +1,113 @@
+// utf8_validator against a straightforward decoder, on random text with random damage.
+// Build with -mssse3 or -mavx2 to test the SIMD paths too (see run_tests.sh).
+#include "test_common.h"
+#include "../utf8_validate.h"
+#include "../file_read_chunks.h"
+#include <fstream>
+#include <random>
+#include <vector>
+#include <cstring>
+
+// Decodes every sequence, and checks what the standard forbids: overlong forms, surrogates, > U+10FFFF.
+static bool reference_valid(const std::string& s){
+    const unsigned char* p = (const unsigned char*)s.data();
+    size_t i = 0;
+    while(i < s.size()){
+        const unsigned c = p[i];
+        if(c < 0x80){ ++i;  continue; }
+        int len;
+        unsigned cp;
+        if(c >= 0xC2 && c <= 0xDF){      len = 2;  cp = c & 0x1F; }
+        else if(c >= 0xE0 && c <= 0xEF){ len = 3;  cp = c & 0x0F; }
+        else if(c >= 0xF0 && c <= 0xF4){ len = 4;  cp = c & 0x07; }
+        else{ return false; }
+        if(i + len > s.size()){ return false; }
+        for(int k=1; k<len; ++k){
+            if((p[i+k] & 0xC0) != 0x80){ return false; }
+            cp = (cp << 6) | (p[i+k] & 0x3F);
+        }
+        if(len == 3 && cp < 0x800){ return false; }
+        if(len == 4 && cp < 0x10000){ return false; }
+        if(cp > 0x10FFFF  ||  (cp >= 0xD800 && cp <= 0xDFFF)){ return false; }
+        i += len;
+    }
+    return true;
+}
+
+static void append_utf8(std::string& s,  unsigned cp){
+    if(cp < 0x80){ s += char(cp); }
+    else if(cp < 0x800){ s += char(0xC0 | cp >> 6);  s += char(0x80 | (cp & 63)); }
+    else if(cp < 0x10000){ s += char(0xE0 | cp >> 12);  s += char(0x80 | ((cp >> 6) & 63));  s += char(0x80 | (cp & 63)); }
+    else{ s += char(0xF0 | cp >> 18);  s += char(0x80 | ((cp >> 12) & 63));  s += char(0x80 | ((cp >> 6) & 63));  s += char(0x80 | (cp & 63)); }
+}
+
+
+static void test_fuzz(){
+    std::mt19937 rng(1);
+    for(int t=0; t<300000; ++t){
+        std::string s;
+        const int numChars = rng() % 200;
+        const bool asciiOnly = rng() % 4 == 0;//long ASCII runs take the fast path
+        for(int k=0; k<numChars; ++k){
+            const unsigned r = rng() % 100;
+            unsigned cp;
+            if(asciiOnly || r < 30){ cp = rng() % 0x80; }
+            else if(r < 60){ cp = 0x80 + rng() % (0x800 - 0x80); }
+            else if(r < 90){ do{ cp = 0x800 + rng() % (0x10000 - 0x800); }while(cp >= 0xD800 && cp <= 0xDFFF); }
+            else{ cp = 0x10000 + rng() % (0x110000 - 0x10000); }
+            append_utf8(s, cp);
+        }
+        const int numDamaged =  rng() % 3 == 0 ? 0 : 1 + rng() % 3;
+        for(int m=0; m<numDamaged && !s.empty(); ++m){
+            const size_t at = rng() % s.size();
+            switch(rng() % 4){
+                case 0: s[at] = char(rng());  break;
+                case 1: s.erase(at, 1);  break;
+                case 2: s.insert(at, 1, char(0x80 + rng() % 64));  break;
+                default: s[at] = char(0xC0 + rng() % 64);  break;
+            }
+        }
+        const bool expected = reference_valid(s);
+        CHECK(utf8_valid(s) == expected);
+
+        //copy() in one go
+        utf8_validator whole;
+        std::vector<unsigned char> dst(s.size());
+        whole.copy(dst.data(), (const unsigned char*)s.data(), s.size());
+        CHECK(whole.finish() == expected);
+        CHECK(std::memcmp(dst.data(), s.data(), s.size()) == 0);
+
+        //check() in pieces: sequences get cut between calls
+        utf8_validator pieces;
+        for(size_t i=0; i<s.size(); ){
+            const size_t n = std::min<size_t>(s.size() - i,  1 + rng() % 70);
+            pieces.check(s.data() + i, n);
+            i += n;
+        }
+        CHECK(pieces.finish() == expected);
+    }
+}
+
+
+static void test_reader(){
+    std::string text;
+    for(int i=0; i<20000; ++i){ text += "h\xC3\xA9llo w\xC3\xB6rld \xE6\x97\xA5\xE6\x9C\xAC \xF0\x9F\x98\x80 plain ascii text. "; }
+    const std::string path = temp_path("utf8.txt");
+    {
+        std::ofstream f(path, std::ios::binary);
+        f << text << "\xC3";//cut in the middle of a sequence
+    }
+    file_read_chunks r(4096);
+    r.BeginRead(path);
+    std::string out;
+    CHECK(r.read_String_utf8(out, text.size()));
+    CHECK(out == text);
+    CHECK(!r.read_String_utf8(out, 1));
+}
+
+
+int main(){
+    test_fuzz();
+    test_reader();
+    return 0;
+}
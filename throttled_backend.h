@@ -0,0 +1,114 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <chrono>
+#include <thread>
+#include <mutex>
+#include <random>
+#include <atomic>
+#include "io_backends.h"
+
+// Describes the device that 'throttled_backend' pretends to be.
+// For example, a typical 7200rpm HDD:   { 150e6,  8ms,  4ms }
+struct simulated_device {
+    double bandwidth_bytesPerSec = 0;//0 means unlimited
+    std::chrono::microseconds latency{0};//added to every request (seek + rotation)
+    std::chrono::microseconds jitter{0};//request latency is uniformly in [latency-jitter, latency+jitter]
+    uint32_t seed = 12345;//same seed gives same sequence of delays, so runs are reproducible.
+};
+
+
+// Wraps another backend, and makes every read_at() / write_at() take as long as it would on
+// the 'simulated_device'. Use it to check if a chunk size or prefetch strategy actually hides
+// the latency, without needing the slow hardware:
+//
+//   basic_file_read_chunks<throttled_backend<>> reader(chunkSize);
+//   reader.backend().set_device({ 150e6,  std::chrono::milliseconds(8) });
+//
+// Or in front of the memory backends (memory_backends.h), so nothing touches a real disk:
+//
+//   basic_file_writer_chunks<throttled_backend<memory_sink_backend>> writer;
+//   writer.backend().set_device({ 150e6,  std::chrono::milliseconds(8) });
+//   writer.beginWrite("<memory>", 0);   ...   writer.completeWrite();
+//   std::vector<unsigned char>& bytes = writer.backend().inner().bytes();
+//
+//   basic_file_read_chunks<throttled_backend<memory_source_backend>> reader(chunkSize);
+//   reader.backend().inner().set_source(bytes.data(), bytes.size());
+//   reader.BeginRead("<memory>");//the path is ignored
+//
+// The device serves one request at a time, like a real disk head. If both of our buffers issue
+// a request at once, the second one queues behind the first.
+template<typename Inner = default_io_backend>
+class throttled_backend {
+    using clock = std::chrono::steady_clock;
+public:
+    void set_device(const simulated_device& d){
+        std::lock_guard lck(_mu_device);
+        _device = d;
+        _rng.seed(d.seed);
+        _busyUntil = clock::time_point{};
+    }
+
+    Inner& inner(){ return _inner; }
+
+    // Total time the simulated device was busy. Compare against wall time of your
+    // test, to see how much of the I/O was hidden behind processing.
+    std::chrono::nanoseconds busyTime()const{  return std::chrono::nanoseconds(_busy_ns.load());  }
+    size_t numRequests()const{ return _numRequests; }
+
+public:
+    bool open_read(const std::string& path){ return _inner.open_read(path); }
+    bool open_write(const std::string& path,  bool truncate){ return _inner.open_write(path, truncate); }
+    void close(){ _inner.close(); }
+    bool is_open()const{ return _inner.is_open(); }
+    size_t size()const{ return _inner.size(); }
+    void resize(size_t numBytes){ _inner.resize(numBytes); }
+
+    size_t read_at(void* dst,  size_t numBytes,  size_t offset){
+        const clock::time_point finish = reserve_device(numBytes);
+        const size_t got = _inner.read_at(dst, numBytes, offset);
+        std::this_thread::sleep_until(finish);
+        return got;
+    }
+
+    void write_at(const void* src,  size_t numBytes,  size_t offset){
+        const clock::time_point finish = reserve_device(numBytes);
+        _inner.write_at(src, numBytes, offset);
+        std::this_thread::sleep_until(finish);
+    }
+
+private:
+    // Puts the request onto the device's timeline, returns when it will be complete.
+    clock::time_point reserve_device(size_t numBytes){
+        std::lock_guard lck(_mu_device);
+
+        std::chrono::nanoseconds cost = _device.latency;
+        if(_device.jitter.count() > 0){
+            std::uniform_int_distribution<long long> dist(-_device.jitter.count(), _device.jitter.count());
+            cost += std::chrono::microseconds(dist(_rng));
+            if(cost.count() < 0){ cost = std::chrono::nanoseconds(0); }
+        }
+        if(_device.bandwidth_bytesPerSec > 0){
+            cost += std::chrono::nanoseconds( (long long)(numBytes / _device.bandwidth_bytesPerSec * 1e9) );
+        }
+        const clock::time_point now = clock::now();
+        const clock::time_point start = _busyUntil > now ? _busyUntil : now;//queue behind previous request
+        _busyUntil = start + cost;
+        _busy_ns += cost.count();
+        ++_numRequests;
+        return _busyUntil;
+    }
+
+private:
+    Inner _inner;
+
+    simulated_device _device;
+    std::mt19937 _rng{12345};
+    clock::time_point _busyUntil{};
+    std::mutex _mu_device;
+
+    std::atomic<long long> _busy_ns = 0;
+    std::atomic<size_t> _numRequests = 0;
+};
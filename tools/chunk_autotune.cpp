@@ -0,0 +1,65 @@
+// MIT LICENSE
+// Requires C++17
+
+// Measures the device behind a directory, and saves the best chunk sizes as this host's
+// chunk_profile. From then on, file_read_chunks / file_writer_chunks use them by default.
+//
+// Build:
+//     g++ -std=c++17 -O2 -pthread -I.. chunk_autotune.cpp -o chunk_autotune
+//
+// Usage:
+//     chunk_autotune <dir> [--size MB] [--out profilePath] [--dry-run]
+//
+//  dir        a directory on the device you want to tune for
+//  --size     size of the test file in MB (default 256)
+//  --out      where to save the profile (default: chunk_profile::default_path())
+//  --dry-run  only print the measurements
+
+#include "../bench/standalone_shims.h"//LogConsole, nn_dev_assert
+
+#include "../chunk_autotune.h"
+#include <cstdio>
+
+int main(int argc, char** argv){
+    if(argc < 2){
+        std::fprintf(stderr, "usage: %s <dir> [--size MB] [--out profilePath] [--dry-run]\n", argv[0]);
+        return 2;
+    }
+    std::string dir = argv[1];
+    std::string out = chunk_profile::default_path();
+    bool dryRun = false;
+    autotune_options opt;
+
+    for(int i=2; i<argc; ++i){
+        std::string a = argv[i];
+        if(a=="--size" && i+1<argc){ opt.testFileBytes = std::stoull(argv[++i]) << 20; }
+        else if(a=="--out" && i+1<argc){ out = argv[++i]; }
+        else if(a=="--dry-run"){ dryRun = true; }
+    }
+
+    std::vector<autotune_sample> samples;
+    chunk_profile p;
+    try{
+        p = autotune_chunk_sizes(dir, opt, &samples);
+    }catch(const std::exception& e){
+        std::fprintf(stderr, "calibration failed: %s\n", e.what());
+        return 1;
+    }
+
+    std::printf("%10s %12s %12s\n", "chunk", "write GB/s", "read GB/s");
+    for(const autotune_sample& s : samples){
+        std::printf("%9zuK %12.3f %12.3f\n", s.chunkBytes >> 10, s.write_GBps, s.read_GBps);
+    }
+    std::printf("\nchosen:  read chunk %zuK,  write buffer %zuK\n", p.read_chunkBytes >> 10, p.write_bufferBytes >> 10);
+
+    if(dryRun){ return 0; }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(out).parent_path(), ec);
+    if(!p.save(out)){
+        std::fprintf(stderr, "couldn't save profile to %s\n", out.c_str());
+        return 1;
+    }
+    std::printf("saved to %s\n", out.c_str());
+    return 0;
+}
@@ -0,0 +1,263 @@
+// MIT LICENSE
+// igor.aherne.business@gmail.com
+// Requires C++17
+
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(__AVX2__)
+    #include <immintrin.h>
+#elif defined(__SSSE3__)
+    #include <tmmintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+    #include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+    #define UTF8_VALIDATE_LOOKUP 1
+#endif
+
+// Checks UTF-8 while the bytes are being copied, so the text is only touched once.
+// Used by file_read_chunks::read_String_utf8(). Also works on views:  utf8_valid(field)
+//
+// Text can be given in pieces (for example, chunk after chunk). A character split
+// between two pieces is fine, it's remembered until the next piece.
+//
+//   utf8_validator v;
+//   v.copy(dst, src, n);      <-- as many times as needed
+//   bool ok = v.finish();     <-- false if anything was invalid, or the text ended mid-character
+//
+// ASCII is checked 32 (AVX2) or 16 (SSE2) or 8 bytes at a time.
+// Other text is checked a block at a time too with AVX2 or SSSE3: three table lookups (pshufb)
+// per block classify every pair of neighbouring bytes (Keiser & Lemire, "Validating UTF-8 In
+// Less Than One Instruction Per Byte"). Without them, and for a character split between pieces,
+// a byte-by-byte state machine is used. Both reject overlong forms, surrogates and > U+10FFFF.
+class utf8_validator {
+public:
+    // Copies 'numBytes' from 'src' into 'dst', and checks them.
+    // 'dst' can be nullptr to only check.
+    void copy(unsigned char* dst,  const unsigned char* src,  size_t numBytes){
+        size_t i = 0;
+        while(i < numBytes){
+            //fast path: whole blocks of ASCII, when we aren't inside a multi-byte character.
+            if(_need == 0){
+                const size_t numAscii = copy_ascii_blocks(dst ? dst + i : nullptr,  src + i,  numBytes - i);
+                i += numAscii;
+                if(i >= numBytes){ break; }
+            #if defined(UTF8_VALIDATE_LOOKUP)
+                i += copy_mixed_blocks(dst ? dst + i : nullptr,  src + i,  numBytes - i);
+                if(i >= numBytes){ break; }
+            #endif
+            }
+            //slow path: until the end of the current block, then try the fast one again.
+            const size_t blockEnd = (i + k_block < numBytes) ? i + k_block : numBytes;
+            for(; i < blockEnd; ++i){
+                if(dst){ dst[i] = src[i]; }
+                step(src[i]);
+            }
+        }
+    }
+
+    void check(const void* bytes,  size_t numBytes){  copy(nullptr, (const unsigned char*)bytes, numBytes);  }
+
+    // True if everything so far was valid, and the last character is complete.
+    bool finish()const{  return _valid  &&  _need == 0;  }
+
+    void reset(){  _valid = true;  _need = 0;  _lo = 0x80;  _hi = 0xBF;  }
+
+
+private:
+#if defined(__AVX2__)
+    static constexpr size_t k_block = 32;
+#elif defined(__SSE2__) || defined(_M_X64)
+    static constexpr size_t k_block = 16;
+#else
+    static constexpr size_t k_block = 8;
+#endif
+
+    // Returns how many bytes were copied: whole blocks, up to the first one with a non-ASCII byte.
+    static size_t copy_ascii_blocks(unsigned char* dst,  const unsigned char* src,  size_t numBytes){
+        size_t i = 0;
+        for(; i + k_block <= numBytes;  i += k_block){
+        #if defined(__AVX2__)
+            const __m256i v = _mm256_loadu_si256((const __m256i*)(src + i));
+            if(_mm256_movemask_epi8(v) != 0){ break; }//some byte has its top bit set
+            if(dst){ _mm256_storeu_si256((__m256i*)(dst + i), v); }
+        #elif defined(__SSE2__) || defined(_M_X64)
+            const __m128i v = _mm_loadu_si128((const __m128i*)(src + i));
+            if(_mm_movemask_epi8(v) != 0){ break; }
+            if(dst){ _mm_storeu_si128((__m128i*)(dst + i), v); }
+        #else
+            uint64_t v;
+            std::memcpy(&v, src + i, 8);
+            if(v & 0x8080808080808080ull){ break; }
+            if(dst){ std::memcpy(dst + i, &v, 8); }
+        #endif
+        }
+        return i;
+    }
+
+
+#if defined(UTF8_VALIDATE_LOOKUP)
+    #if defined(__AVX2__)
+        using vec = __m256i;
+        static vec v_load(const unsigned char* p){  return _mm256_loadu_si256((const __m256i*)p);  }
+        static void v_store(unsigned char* p,  vec v){  _mm256_storeu_si256((__m256i*)p, v);  }
+        static vec v_table(const unsigned char* t16){  return _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)t16));  }
+        static vec v_set1(unsigned char b){  return _mm256_set1_epi8((char)b);  }
+        static vec v_lookup(vec table,  vec ix){  return _mm256_shuffle_epi8(table, ix);  }
+        static vec v_and(vec a,  vec b){  return _mm256_and_si256(a, b);  }
+        static vec v_or(vec a,  vec b){   return _mm256_or_si256(a, b);  }
+        static vec v_xor(vec a,  vec b){  return _mm256_xor_si256(a, b);  }
+        static vec v_subs(vec a,  vec b){ return _mm256_subs_epu8(a, b);  }
+        static vec v_high4(vec v){  return _mm256_and_si256(_mm256_srli_epi16(v, 4), v_set1(0x0F));  }
+        static bool v_any(vec v){  return !_mm256_testz_si256(v, v);  }
+        static bool v_isAscii(vec v){  return _mm256_movemask_epi8(v) == 0;  }
+        // bytes of 'input', shifted along by N: the first N come from the end of 'prev'
+        template<int N>
+        static vec v_prev(vec input,  vec prev){  return _mm256_alignr_epi8(input, _mm256_permute2x128_si256(prev, input, 0x21), 16 - N);  }
+    #else
+        using vec = __m128i;
+        static vec v_load(const unsigned char* p){  return _mm_loadu_si128((const __m128i*)p);  }
+        static void v_store(unsigned char* p,  vec v){  _mm_storeu_si128((__m128i*)p, v);  }
+        static vec v_table(const unsigned char* t16){  return _mm_loadu_si128((const __m128i*)t16);  }
+        static vec v_set1(unsigned char b){  return _mm_set1_epi8((char)b);  }
+        static vec v_lookup(vec table,  vec ix){  return _mm_shuffle_epi8(table, ix);  }
+        static vec v_and(vec a,  vec b){  return _mm_and_si128(a, b);  }
+        static vec v_or(vec a,  vec b){   return _mm_or_si128(a, b);  }
+        static vec v_xor(vec a,  vec b){  return _mm_xor_si128(a, b);  }
+        static vec v_subs(vec a,  vec b){ return _mm_subs_epu8(a, b);  }
+        static vec v_high4(vec v){  return _mm_and_si128(_mm_srli_epi16(v, 4), v_set1(0x0F));  }
+        static bool v_any(vec v){  return _mm_movemask_epi8(_mm_cmpeq_epi8(v, _mm_setzero_si128())) != 0xFFFF;  }
+        static bool v_isAscii(vec v){  return _mm_movemask_epi8(v) == 0;  }
+        template<int N>
+        static vec v_prev(vec input,  vec prev){  return _mm_alignr_epi8(input, prev, 16 - N);  }
+    #endif
+
+    // Checks whole blocks that may have non-ASCII, while we aren't inside a character.
+    // Returns how many bytes were copied and checked. If the last block ends in the middle
+    // of a character, stops where that character begins: step() takes it from there.
+    size_t copy_mixed_blocks(unsigned char* dst,  const unsigned char* src,  size_t numBytes){
+        //what each pair of bytes can be wrong with, by the high half of the first, its low half,
+        //and the high half of the second. A pair is invalid if all three agree on some bit.
+        constexpr unsigned char TOO_SHORT = 1<<0;//lead, then not a continuation
+        constexpr unsigned char TOO_LONG = 1<<1;//ASCII, then a continuation
+        constexpr unsigned char OVERLONG_3 = 1<<2;
+        constexpr unsigned char TOO_LARGE = 1<<3;
+        constexpr unsigned char SURROGATE = 1<<4;
+        constexpr unsigned char OVERLONG_2 = 1<<5;
+        constexpr unsigned char TOO_LARGE_1000 = 1<<6;
+        constexpr unsigned char OVERLONG_4 = 1<<6;
+        constexpr unsigned char TWO_CONTS = 1<<7;//two continuations: only fine as the 3rd or 4th byte
+        constexpr unsigned char CARRY = TOO_SHORT | TOO_LONG | TWO_CONTS;
+
+        alignas(16) static constexpr unsigned char k_byte1High[16] = {
+            TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG, TOO_LONG,
+            TWO_CONTS, TWO_CONTS, TWO_CONTS, TWO_CONTS,
+            TOO_SHORT | OVERLONG_2,
+            TOO_SHORT,
+            TOO_SHORT | OVERLONG_3 | SURROGATE,
+            TOO_SHORT | TOO_LARGE | TOO_LARGE_1000 | OVERLONG_4 };
+        alignas(16) static constexpr unsigned char k_byte1Low[16] = {
+            CARRY | OVERLONG_3 | OVERLONG_2 | OVERLONG_4,
+            CARRY | OVERLONG_2,
+            CARRY,
+            CARRY,
+            CARRY | TOO_LARGE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,  CARRY | TOO_LARGE | TOO_LARGE_1000,  CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,  CARRY | TOO_LARGE | TOO_LARGE_1000,  CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,  CARRY | TOO_LARGE | TOO_LARGE_1000,
+            CARRY | TOO_LARGE | TOO_LARGE_1000 | SURROGATE,
+            CARRY | TOO_LARGE | TOO_LARGE_1000,  CARRY | TOO_LARGE | TOO_LARGE_1000 };
+        alignas(16) static constexpr unsigned char k_byte2High[16] = {
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE_1000 | OVERLONG_4,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | OVERLONG_3 | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_LONG | OVERLONG_2 | TWO_CONTS | SURROGATE | TOO_LARGE,
+            TOO_SHORT, TOO_SHORT, TOO_SHORT, TOO_SHORT };
+        //a lead byte this close to the end of a block, continues into the next block:
+        alignas(32) static constexpr unsigned char k_incompleteMax[32] = {
+            255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,255,
+            255,255,255,255,255,255,255,255,255,255,255,255,255,
+            0xF0-1, 0xE0-1, 0xC0-1 };
+
+        const vec byte1High = v_table(k_byte1High);
+        const vec byte1Low =  v_table(k_byte1Low);
+        const vec byte2High = v_table(k_byte2High);
+        const vec incompleteMax = v_load(k_incompleteMax + 32 - k_block);
+
+        vec prev = v_set1(0);//we start at a character boundary: as if ASCII came before
+        vec error = v_set1(0);
+        bool prevIncomplete = false;
+        size_t i = 0;
+        for(; i + k_block <= numBytes;  i += k_block){
+            const vec input = v_load(src + i);
+            if(dst){ v_store(dst + i, input); }
+            if(v_isAscii(input)){
+                if(prevIncomplete){ _valid = false; }
+                prevIncomplete = false;
+                prev = input;
+                continue;
+            }
+            const vec prev1 = v_prev<1>(input, prev);
+            const vec special = v_and(v_and(v_lookup(byte1High, v_high4(prev1)),
+                                            v_lookup(byte1Low,  v_and(prev1, v_set1(0x0F)))),
+                                      v_lookup(byte2High, v_high4(input)));
+            //2 continuations in a row are fine only if a 3 or 4 byte lead came before them:
+            const vec isThird =  v_subs(v_prev<2>(input, prev), v_set1(0xE0 - 0x80));
+            const vec isFourth = v_subs(v_prev<3>(input, prev), v_set1(0xF0 - 0x80));
+            const vec must23 = v_and(v_or(isThird, isFourth), v_set1(0x80));
+            error = v_or(error, v_xor(must23, special));
+
+            prevIncomplete = v_any(v_subs(input, incompleteMax));
+            prev = input;
+        }
+        if(v_any(error)){ _valid = false; }
+        if(prevIncomplete){
+            //go back to the lead byte of the unfinished character:
+            size_t lead = i;
+            while(lead > i - 3  &&  (src[lead-1] & 0xC0) == 0x80){ --lead; }
+            return lead - 1;
+        }
+        return i;
+    }
+#endif
+
+
+    void step(unsigned char b){
+        if(_need > 0){
+            if(b < _lo  ||  b > _hi){ _valid = false;  _need = 0;  }
+            else{ --_need; }
+            _lo = 0x80;  _hi = 0xBF;
+            return;
+        }
+        if(b < 0x80){ return; }
+        //the first continuation byte is narrowed for the lead bytes that could make an overlong form,
+        //a surrogate (U+D800..DFFF) or something above U+10FFFF:
+        if(b >= 0xC2 && b <= 0xDF){ _need = 1; }
+        else if(b == 0xE0){ _need = 2;  _lo = 0xA0; }
+        else if(b == 0xED){ _need = 2;  _hi = 0x9F; }
+        else if(b >= 0xE1 && b <= 0xEF){ _need = 2; }
+        else if(b == 0xF0){ _need = 3;  _lo = 0x90; }
+        else if(b >= 0xF1 && b <= 0xF3){ _need = 3; }
+        else if(b == 0xF4){ _need = 3;  _hi = 0x8F; }
+        else{ _valid = false; }//stray continuation byte, C0, C1, F5..FF
+    }
+
+
+private:
+    bool _valid = true;
+    unsigned _need = 0;//continuation bytes still expected
+    unsigned char _lo = 0x80;//allowed range of the next continuation byte
+    unsigned char _hi = 0xBF;
+};
+
+
+inline bool utf8_valid(std::string_view text){
+    utf8_validator v;
+    v.check(text.data(), text.size());
+    return v.finish();
+}